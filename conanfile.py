@@ -11,8 +11,9 @@ class QZeroMQConan(ConanFile):
     exports_sources = ["src/*", "perf/*", "QZeroMQConfig.cmake.in", "CMakeLists.txt"]
     settings = "os", "compiler", "build_type", "arch"
     generators = "cmake", "cmake_find_package"
-    options = {"shared": [True, False]}
-    default_options = {"shared": False}
+    options = {"shared": [True, False], "draft": [True, False], "coroutines": [True, False],
+               "lz4": [True, False], "zstd": [True, False]}
+    default_options = {"shared": False, "draft": False, "coroutines": False, "lz4": False, "zstd": False}
 
     _git_is_dirty = False
     _git_commit = "unknown"
@@ -33,6 +34,10 @@ class QZeroMQConan(ConanFile):
     def requirements(self):
         self.requires("qt/5.14.2@bincrafters/stable")
         self.requires("zeromq/4.3.3")
+        if self.options.lz4:
+            self.requires("lz4/1.9.2")
+        if self.options.zstd:
+            self.requires("zstd/1.4.5")
 
     def _configure_cmake(self):
         if not self._cmake:
@@ -48,6 +53,10 @@ class QZeroMQConan(ConanFile):
             else:
                 self._cmake.definitions["ZMQ_SHARED"] = "OFF"
             self._cmake.definitions["WITH_PERF_TOOL"] = "ON"    
+            self._cmake.definitions["WITH_DRAFT_API"] = "ON" if self.options.draft else "OFF"
+            self._cmake.definitions["WITH_COROUTINES"] = "ON" if self.options.coroutines else "OFF"
+            self._cmake.definitions["WITH_LZ4"] = "ON" if self.options.lz4 else "OFF"
+            self._cmake.definitions["WITH_ZSTD"] = "ON" if self.options.zstd else "OFF"
             self._cmake.definitions["USE_CONAN_BUILD_INFO"] = "ON"
             self._cmake.definitions["SOURCE_VERSION"] = self.version
             self._cmake.definitions["SOURCE_COMMIT"] = self._git_commit
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "inproc_lat.hpp"
+#include "perf_dispatcher.hpp"
 #include <qzmq.hpp>
 #include <zmq.h>
 #include <cstdio>
@@ -25,6 +26,8 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 {
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
+    parser.addOption(histogramOption());
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "roundtrip count");
     parser.process(*this);
@@ -41,11 +44,14 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
     this->socket = NULL;
     this->msgQueued = NULL;
     this->watch = NULL;
+    this->histogramFile = parser.value("histogram");
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
 
     this->worker = new WorkerThread(this->msgSize, this);
+    setupEventDispatcher(this->worker, parser.value("dispatcher").toLatin1().constData());
     this->worker->start();
 
     QTimer::singleShot(0, this, &App::started); 
@@ -75,8 +81,10 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         return;
     }
 
+    this->histogram.record(this->roundTrip.nsecsElapsed());
     this->msgCount++;
     if (this->msgCount < this->maxMsgs) {
+        this->roundTrip.start();
         if (!this->socket->send(msg)) {
             int error = QZmqError::getLastError();
             const char *errStr = QZmqError::getLastError(error);
@@ -92,6 +100,10 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         uint64_t elapsed = zmq_stopwatch_stop(this->watch);
         double latency = (double)elapsed / (this->msgCount * 2);
         qInfo() << "Average latency:" << latency << "us";
+        this->histogram.report("Round trip latency");
+        if (!this->histogramFile.isEmpty() && !this->histogram.dump(this->histogramFile)) {
+            qCritical() << "Cannot write the histogram to" << this->histogramFile;
+        }
         delete msg;
         this->worker->quit();
         this->worker->wait();
@@ -102,6 +114,7 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
 void App::onReadyToSend(QZmqSocket *socket)
 {
     if (this->msgQueued != NULL) {
+        this->roundTrip.start();
         if (!this->socket->send(this->msgQueued)) {
             int error = QZmqError::getLastError();
             const char *errStr = QZmqError::getLastError(error);
@@ -140,6 +153,7 @@ void App::started()
     }
 
     this->watch = zmq_stopwatch_start();
+    this->roundTrip.start();
 
     QZmqMessage *msg = QZmqMessage::create(this->msgSize);
     if (!this->socket->send(msg)) {
@@ -242,6 +256,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
@@ -15,7 +15,9 @@
 #ifndef __INPROC_LAT_H__
 #define __INPROC_LAT_H__
 
+#include "perf_histogram.hpp"
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QThread>
 
 class QZmqSocket;
@@ -61,6 +63,9 @@ private:
     int maxMsgs;
     bool dontExit;
     void* watch;
+    QElapsedTimer roundTrip;
+    LatencyHistogram histogram;
+    QString histogramFile;
 };
 
 #endif // __INPROC_LAT_H__
\ No newline at end of file
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "inproc_thr.hpp"
+#include "perf_dispatcher.hpp"
 #include <cstdint>
 #include <qzmq.hpp>
 #include <zmq.h>
@@ -22,11 +23,15 @@
 #include <QDateTime>
 #include <QCommandLineParser>
 
+constexpr int SEND_QUEUE_LIMIT = 1000;
+
 App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 {
 
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
+    parser.addOption(QCommandLineOption("coalesce", "pack messages into batch frames (coalescing mode)"));
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "message count");
     parser.process(*this);
@@ -40,13 +45,17 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
     this->msgCount = 0;
     this->msgSize = args[0].toInt();
     this->maxMsgs = args[1].toInt();
+    this->coalesce = parser.isSet("coalesce");
     this->socket = NULL;
     this->watch = NULL;
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
+    qInfo() << "Coalescing   :" << this->coalesce;
 
-    this->worker = new WorkerThread(this->msgSize, this->maxMsgs, this);
+    this->worker = new WorkerThread(this->msgSize, this->maxMsgs, this->coalesce, this);
+    setupEventDispatcher(this->worker, parser.value("dispatcher").toLatin1().constData());
     this->worker->start();
     QTimer::singleShot(0, this, &App::started); 
 }
@@ -71,14 +80,14 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
     } 
 
     if (msg->size() != this->msgSize) {
-        delete msg;
+        msg->release();
         qCritical() << "Message of incorrect size received";
         this->worker->quit();
         this->worker->wait();
         App::exit(-1);
         return;
     }
-    delete msg;
+    msg->release();
 
     this->msgCount++;
     if (this->msgCount == this->maxMsgs) {
@@ -87,6 +96,8 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         double megabits = (double)(throughput * this->msgSize * 8) / 1000000;
         qInfo() << "Mean throughput:" << throughput << "msg/s";
         qInfo() << "Mean throughput:" << megabits << "Mb/s";
+        qInfo() << "Pool hits      :" << QZmqMessagePool::instance()->hits();
+        qInfo() << "Pool misses    :" << QZmqMessagePool::instance()->misses();
         this->worker->quit();
         this->worker->wait();
         App::exit();
@@ -94,6 +105,14 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
     }
 }
 
+// In coalescing mode, the messages of all batch frames received in one pass arrive at once.
+void App::onMessages(QZmqSocket *socket, const QVector<QZmqMessage*> &msgs)
+{
+    for (QZmqMessage *msg : msgs) {
+        onMessage(socket, msg);
+    }
+}
+
 void App::onReadyToSend(QZmqSocket *socket)
 {
 
@@ -108,7 +127,10 @@ void App::started()
 {
     this->socket = QZmqSocket::create(ZMQ_PULL);
     Q_ASSERT(this->socket != NULL);
+    this->socket->setMessagePool(QZmqMessagePool::instance());
+    this->socket->setCoalescingMode(this->coalesce);
     connect(this->socket, &QZmqSocket::onMessage, this, &App::onMessage);
+    connect(this->socket, &QZmqSocket::onMessages, this, &App::onMessages);
     connect(this->socket, &QZmqSocket::onReadyToSend, this, &App::onReadyToSend);
     connect(this->socket, &QZmqSocket::onError, this, &App::onError);
 
@@ -121,13 +143,13 @@ void App::started()
     }
 }
 
-WorkerThread::WorkerThread(uint32_t msgSize, uint32_t maxMsgs, QObject *parent) : QThread(parent)
+WorkerThread::WorkerThread(uint32_t msgSize, uint32_t maxMsgs, bool coalesce, QObject *parent) : QThread(parent)
 {
     this->msgCount = 0;
     this->msgSize = msgSize;
     this->maxMsgs = maxMsgs;
+    this->coalesce = coalesce;
     this->socket = NULL;
-    this->msgQueued = NULL;
     connect(this, &QThread::started, this, &WorkerThread::started);
 }
 
@@ -146,28 +168,31 @@ void WorkerThread::onMessage(QZmqSocket *socket, QZmqMessage *msg)
 
 void WorkerThread::onReadyToSend(QZmqSocket *socket)
 {
+    // Queued messages are sent by the socket itself.
+}
+
+void WorkerThread::onLowWater(QZmqSocket *socket)
+{
+    sendMessages();
+}
+
+void WorkerThread::sendMessages()
+{
+    // The socket queues the messages that cannot be sent right away.
+    // Sending continues from onLowWater() once the queue is full.
     while(this->msgCount < this->maxMsgs) {
-        QZmqMessage *msg = NULL;
-        if (this->msgQueued != NULL) {
-            msg = this->msgQueued;
-            this->msgQueued = NULL;
-        } else {
-            msg = QZmqMessage::create(this->msgSize);
-        }
-        if (!this->socket->send(msg)) {
-            int error = QZmqError::getLastError();
+        QZmqMessage *msg = QZmqMessagePool::instance()->acquire(this->msgSize);
+        bool queued = this->socket->enqueue(msg);
+        int error = QZmqError::getLastError();
+        msg->release();
+        if (!queued) {
             if (error != EAGAIN) {
                 const char *errStr = QZmqError::getLastError(error);
-                qCritical() << "Sending failed:" << QZmqError::getLastError() << "-" << errStr;
-                delete msg;
-            } else {
-                this->msgQueued = msg;
+                qCritical() << "Sending failed:" << error << "-" << errStr;
             }
             break;
-        } else {
-            delete msg;
-            this->msgCount++;
         }
+        this->msgCount++;
     }
 }
 
@@ -181,7 +206,10 @@ void WorkerThread::started()
     this->socket = QZmqSocket::create(ZMQ_PUSH);
     connect(this->socket, &QZmqSocket::onMessage, this, &WorkerThread::onMessage);
     connect(this->socket, &QZmqSocket::onReadyToSend, this, &WorkerThread::onReadyToSend);
+    connect(this->socket, &QZmqSocket::onLowWater, this, &WorkerThread::onLowWater);
     connect(this->socket, &QZmqSocket::onError, this, &WorkerThread::onError);
+    this->socket->setSendQueueLimits(SEND_QUEUE_LIMIT);
+    this->socket->setCoalescingMode(this->coalesce);
 
     if(!this->socket->connect("inproc://thr_test")) {
         int error = QZmqError::getLastError();
@@ -190,23 +218,7 @@ void WorkerThread::started()
     }
 
     this->msgCount = 0;
-    while(this->msgCount < this->maxMsgs) {
-        QZmqMessage *msg = QZmqMessage::create(this->msgSize);
-        if (!this->socket->send(msg)) {
-            int error = QZmqError::getLastError();
-            if (error != EAGAIN) {
-                const char *errStr = QZmqError::getLastError(error);
-                qCritical() << "Sending failed:" << QZmqError::getLastError() << "-" << errStr;
-                delete msg;
-            } else {
-                this->msgQueued = msg;
-            }
-            break;
-        } else {
-            delete msg;
-            this->msgCount++;
-        }
-    } 
+    sendMessages();
 }
 
 void customMessageOutput(QtMsgType type, const QMessageLogContext& context, const QString& msg)
@@ -237,6 +249,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
@@ -17,6 +17,7 @@
 
 #include <QCoreApplication>
 #include <QThread>
+#include <QVector>
 
 class QZmqSocket;
 class QZmqMessage;
@@ -25,21 +26,24 @@ class WorkerThread : public QThread
 {
     Q_OBJECT
 public:
-    WorkerThread(uint32_t msgSize, uint32_t maxMsgs, QObject *parent=nullptr);
+    WorkerThread(uint32_t msgSize, uint32_t maxMsgs, bool coalesce, QObject *parent=nullptr);
     virtual ~WorkerThread();
 
 private slots:
     void onMessage(QZmqSocket *socket, QZmqMessage *msg);
     void onReadyToSend(QZmqSocket *socket);
+    void onLowWater(QZmqSocket *socket);
     void onError(QZmqSocket *socket, int error);
     void started();
 
 private:
+    void sendMessages();
+
     QZmqSocket* socket;
-    QZmqMessage* msgQueued;
     uint32_t msgCount;
     uint32_t msgSize;
     uint32_t maxMsgs;
+    bool coalesce;
 };
 
 class App : public QCoreApplication
@@ -51,6 +55,7 @@ public:
 
 private slots:
     void onMessage(QZmqSocket *socket, QZmqMessage *msg);
+    void onMessages(QZmqSocket *socket, const QVector<QZmqMessage*> &msgs);
     void onReadyToSend(QZmqSocket *socket);
     void onError(QZmqSocket *socket, int error);
     void started();
@@ -61,6 +66,7 @@ private:
     int msgCount;
     int msgSize;
     int maxMsgs;
+    bool coalesce;
     void* watch;
 };
 
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "local_lat.hpp"
+#include "perf_dispatcher.hpp"
 #include <cstdint>
 #include <qzmq.hpp>
 #include <zmq.h>
@@ -27,6 +28,7 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 {
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
     parser.addPositionalArgument("bind_to", "bind to");
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "roundtrip count");
@@ -47,6 +49,7 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
 
     QTimer::singleShot(0, this, &App::started);
 }
@@ -137,6 +140,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
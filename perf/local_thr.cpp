@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "local_thr.hpp"
+#include "perf_dispatcher.hpp"
 #include <cstdint>
 #include <qzmq.hpp>
 #include <zmq.h>
@@ -27,6 +28,7 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 {
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
     parser.addPositionalArgument("bind_to", "bind to");
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "roundtrip count");
@@ -48,6 +50,7 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
 
     QTimer::singleShot(0, this, &App::started);
 }
@@ -64,6 +67,7 @@ void App::started()
 {
     this->socket = QZmqSocket::create(ZMQ_PULL);
     Q_ASSERT(this->socket != NULL);
+    this->socket->setMessagePool(QZmqMessagePool::instance());
     connect(this->socket, &QZmqSocket::onMessage, this, &App::onMessage);
     connect(this->socket, &QZmqSocket::onReadyToSend, this, &App::onReadyToSend);
     connect(this->socket, &QZmqSocket::onError, this, &App::onError);
@@ -83,12 +87,12 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
     } 
 
     if (msg->size() != this->msgSize) {
-        delete msg;
+        msg->release();
         qCritical() << "Message of incorrect size received";
         App::exit(-1);
         return;
     }
-    delete msg;
+    msg->release();
 
     this->msgCount++;
     if (this->msgCount == this->maxMsgs) {
@@ -97,6 +101,8 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         double megabits = (double)(throughput * this->msgSize * 8) / 1000000;
         qInfo() << "Mean throughput:" << throughput << "msg/s";
         qInfo() << "Mean throughput:" << megabits << "Mb/s";
+        qInfo() << "Pool hits      :" << QZmqMessagePool::instance()->hits();
+        qInfo() << "Pool misses    :" << QZmqMessagePool::instance()->misses();
         App::exit();
         return;
     }
@@ -140,6 +146,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
@@ -0,0 +1,98 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PERF_DISPATCHER_H__
+#define __PERF_DISPATCHER_H__
+
+#include <qzmq.hpp>
+#include <QAbstractEventDispatcher>
+#include <QCommandLineOption>
+#include <QCoreApplication>
+#include <QThread>
+#include <cstdio>
+#include <cstring>
+
+// Event dispatchers that can be compared with the perf tools:
+//   glib - Qt's default dispatcher on Linux (if Qt is built with glib)
+//   unix - Qt's select/poll based dispatcher
+//   qzmq - QZmqEventDispatcher (Linux only)
+
+inline QCommandLineOption dispatcherOption()
+{
+    return QCommandLineOption("dispatcher", "event dispatcher (glib, unix or qzmq)", "name", "glib");
+}
+
+// Scan the command line for the dispatcher option.
+// This has to be done before QCoreApplication is created.
+inline const char* dispatcherName(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dispatcher") == 0 && i + 1 < argc) {
+            return argv[i + 1];
+        }
+        if (strncmp(argv[i], "--dispatcher=", 13) == 0) {
+            return argv[i] + 13;
+        }
+    }
+    return "glib";
+}
+
+// Create an event dispatcher for a thread. NULL means Qt's default dispatcher.
+inline QAbstractEventDispatcher* createEventDispatcher(const char *name)
+{
+#ifdef Q_OS_LINUX
+    if (strcmp(name, "qzmq") == 0) {
+        return new QZmqEventDispatcher();
+    }
+#endif
+    return NULL;
+}
+
+// Select the event dispatcher of the main thread and of the threads started later.
+// Must be called before QCoreApplication is created.
+inline bool setupEventDispatcher(const char *name)
+{
+    if (strcmp(name, "glib") == 0) {
+        qunsetenv("QT_NO_GLIB");
+    } else if (strcmp(name, "unix") == 0) {
+        qputenv("QT_NO_GLIB", "1");
+    } else if (strcmp(name, "qzmq") == 0) {
+        QAbstractEventDispatcher *dispatcher = createEventDispatcher(name);
+        if (dispatcher == NULL) {
+            fprintf(stderr, "Event dispatcher is not supported on this platform: %s\n", name);
+            return false;
+        }
+        QCoreApplication::setEventDispatcher(dispatcher);
+    } else {
+        fprintf(stderr, "Unknown event dispatcher: %s\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Use the selected event dispatcher for a thread that is not started yet.
+// Qt picks between glib and unix dispatchers when the thread starts.
+inline void setupEventDispatcher(QThread *thread, const char *name)
+{
+    QAbstractEventDispatcher *dispatcher = createEventDispatcher(name);
+    if (dispatcher != NULL) {
+        thread->setEventDispatcher(dispatcher);
+    } else if (strcmp(name, "unix") == 0) {
+        qputenv("QT_NO_GLIB", "1");
+    } else {
+        qunsetenv("QT_NO_GLIB");
+    }
+}
+
+#endif // __PERF_DISPATCHER_H__
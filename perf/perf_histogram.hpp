@@ -0,0 +1,190 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PERF_HISTOGRAM_H__
+#define __PERF_HISTOGRAM_H__
+
+#include <QtAlgorithms>
+#include <QCommandLineOption>
+#include <QDebug>
+#include <QString>
+#include <cstdio>
+#include <vector>
+
+// Output file for the full latency distribution.
+// The distribution is written as JSON if the file name ends with .json, otherwise as CSV.
+inline QCommandLineOption histogramOption()
+{
+    return QCommandLineOption("histogram", "write the latency distribution to a CSV or JSON file", "file");
+}
+
+// HDR style histogram of latencies in nanoseconds.
+// Values below 2^SUB_BUCKET_BITS are recorded exactly. Larger values are recorded in
+// logarithmic buckets that are split into 2^(SUB_BUCKET_BITS-1) linear sub-buckets,
+// so the relative error is below 1% over the whole range. Recording does not allocate.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 8;
+    static constexpr quint64 SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static constexpr quint64 SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+
+    LatencyHistogram() : counts(SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF, 0)
+    {
+        this->total = 0;
+        this->sum = 0;
+        this->minValue = 0;
+        this->maxValue = 0;
+    }
+
+    inline void record(qint64 nsecs)
+    {
+        quint64 value = nsecs < 0 ? 0 : (quint64)nsecs;
+        this->counts[index(value)]++;
+        if (this->total == 0 || value < this->minValue) {
+            this->minValue = value;
+        }
+        if (value > this->maxValue) {
+            this->maxValue = value;
+        }
+        this->total++;
+        this->sum += value;
+    }
+
+    // Merge the values recorded by another histogram, e.g. of another thread.
+    void add(const LatencyHistogram &other)
+    {
+        if (other.total == 0) {
+            return;
+        }
+        for (size_t i = 0; i < this->counts.size(); i++) {
+            this->counts[i] += other.counts[i];
+        }
+        if (this->total == 0 || other.minValue < this->minValue) {
+            this->minValue = other.minValue;
+        }
+        this->maxValue = qMax(this->maxValue, other.maxValue);
+        this->total += other.total;
+        this->sum += other.sum;
+    }
+
+    quint64 count() const { return this->total; }
+    quint64 min() const { return this->minValue; }
+    quint64 max() const { return this->maxValue; }
+    double mean() const { return this->total == 0 ? 0 : (double)this->sum / this->total; }
+
+    // Highest value below which the given percentage of the recorded values fall.
+    quint64 percentile(double percent) const
+    {
+        if (this->total == 0) {
+            return 0;
+        }
+        quint64 target = (quint64)(percent / 100.0 * this->total + 0.5);
+        if (target < 1) {
+            target = 1;
+        }
+        quint64 cumulative = 0;
+        for (size_t i = 0; i < this->counts.size(); i++) {
+            cumulative += this->counts[i];
+            if (cumulative >= target) {
+                return qMin(highestValue(i), this->maxValue);
+            }
+        }
+        return this->maxValue;
+    }
+
+    void report(const char *title) const
+    {
+        qInfo() << title << "(us)";
+        qInfo() << "  p50  :" << percentile(50.0) / 1000.0;
+        qInfo() << "  p90  :" << percentile(90.0) / 1000.0;
+        qInfo() << "  p99  :" << percentile(99.0) / 1000.0;
+        qInfo() << "  p99.9:" << percentile(99.9) / 1000.0;
+        qInfo() << "  max  :" << max() / 1000.0;
+    }
+
+    // Write every non-empty bucket with its cumulative percentile. Values are in microseconds.
+    bool dump(const QString &path) const
+    {
+        FILE *file = fopen(path.toLocal8Bit().constData(), "w");
+        if (file == NULL) {
+            return false;
+        }
+
+        bool json = path.endsWith(".json", Qt::CaseInsensitive);
+        if (json) {
+            fprintf(file, "{\n  \"count\": %llu,\n  \"min\": %.3f,\n  \"mean\": %.3f,\n  \"max\": %.3f,\n",
+                    (unsigned long long)this->total, this->minValue / 1000.0, mean() / 1000.0, this->maxValue / 1000.0);
+            fprintf(file, "  \"percentiles\": {\"50\": %.3f, \"90\": %.3f, \"99\": %.3f, \"99.9\": %.3f, \"99.99\": %.3f},\n",
+                    percentile(50.0) / 1000.0, percentile(90.0) / 1000.0, percentile(99.0) / 1000.0,
+                    percentile(99.9) / 1000.0, percentile(99.99) / 1000.0);
+            fprintf(file, "  \"buckets\": [");
+        } else {
+            fprintf(file, "value_us,count,percentile\n");
+        }
+
+        quint64 cumulative = 0;
+        bool first = true;
+        for (size_t i = 0; i < this->counts.size(); i++) {
+            if (this->counts[i] == 0) {
+                continue;
+            }
+            cumulative += this->counts[i];
+            double value = qMin(highestValue(i), this->maxValue) / 1000.0;
+            double percent = 100.0 * cumulative / this->total;
+            if (json) {
+                fprintf(file, "%s\n    {\"value\": %.3f, \"count\": %llu, \"percentile\": %.6f}",
+                        first ? "" : ",", value, (unsigned long long)this->counts[i], percent);
+            } else {
+                fprintf(file, "%.3f,%llu,%.6f\n", value, (unsigned long long)this->counts[i], percent);
+            }
+            first = false;
+        }
+
+        if (json) {
+            fprintf(file, "\n  ]\n}\n");
+        }
+        return fclose(file) == 0;
+    }
+
+protected:
+    static inline size_t index(quint64 value)
+    {
+        if (value < SUB_BUCKET_COUNT) {
+            return (size_t)value;
+        }
+        int shift = 64 - qCountLeadingZeroBits(value) - SUB_BUCKET_BITS;
+        quint64 subBucket = value >> shift;
+        return (size_t)(SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + (subBucket - SUB_BUCKET_HALF));
+    }
+
+    static inline quint64 highestValue(size_t index)
+    {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+        quint64 offset = index - SUB_BUCKET_COUNT;
+        int shift = (int)(offset / SUB_BUCKET_HALF) + 1;
+        quint64 subBucket = SUB_BUCKET_HALF + offset % SUB_BUCKET_HALF;
+        return (subBucket << shift) + ((1ULL << shift) - 1);
+    }
+
+    std::vector<quint64> counts;
+    quint64 total;
+    quint64 sum;
+    quint64 minValue;
+    quint64 maxValue;
+};
+
+#endif // __PERF_HISTOGRAM_H__
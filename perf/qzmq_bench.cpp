@@ -0,0 +1,641 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmq_bench.hpp"
+#include "perf_dispatcher.hpp"
+#include <zmq.h>
+#include <cerrno>
+#include <cstdio>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QVector>
+
+constexpr int SEND_QUEUE_LIMIT = 1000;
+// Subscriptions have to reach the publishers before the first message is sent.
+constexpr int SLOW_JOINER_DELAY = 200;
+
+static int receiverType(const QString &pattern)
+{
+    if (pattern == "pubsub") {
+        return ZMQ_SUB;
+    } else if (pattern == "reqrep") {
+        return ZMQ_REP;
+    }
+    return ZMQ_PULL;
+}
+
+static int senderType(const QString &pattern)
+{
+    if (pattern == "pubsub") {
+        return ZMQ_PUB;
+    } else if (pattern == "reqrep") {
+        return ZMQ_REQ;
+    }
+    return ZMQ_PUSH;
+}
+
+// Repetitive text, like serialized records, so that compression has something to work on.
+static QByteArray makePayload(int size)
+{
+    static const QByteArray record = "{\"symbol\":\"QZMQ\",\"bid\":101.25,\"ask\":101.27,\"volume\":4200},";
+    QByteArray payload;
+    payload.reserve(size);
+    for (int i = 0; payload.size() < size; i++) {
+        payload.append(record);
+        payload.append(QByteArray::number(i));
+    }
+    payload.truncate(size);
+    return payload;
+}
+
+static QString lastEndpoint(void *socket)
+{
+    char endpoint[256];
+    size_t len = sizeof(endpoint);
+    if (zmq_getsockopt(socket, ZMQ_LAST_ENDPOINT, endpoint, &len) != 0) {
+        return QString();
+    }
+    return QString::fromLatin1(endpoint);
+}
+
+BenchThread::BenchThread(const Scenario &scenario, ScenarioState *state, int index)
+{
+    this->scenario = scenario;
+    this->state = state;
+    this->index = index;
+    this->failed = false;
+    this->messages = 0;
+    this->elapsed = 0;
+    this->stats = QZmqSocketStats();
+    this->payload = makePayload(scenario.size);
+}
+
+// Share of the messages sent by this thread. The first thread sends the remainder.
+int BenchThread::quota()
+{
+    int quota = this->scenario.count / this->scenario.threads;
+    if (this->index == 0) {
+        quota += this->scenario.count % this->scenario.threads;
+    }
+    return quota;
+}
+
+QByteArray BenchThread::bindAddress()
+{
+    if (this->scenario.transport == "ipc") {
+        return "ipc://*";
+    } else if (this->scenario.transport == "tcp") {
+        return "tcp://127.0.0.1:*";
+    }
+    return "inproc://qzmq-bench-" + QByteArray::number((quintptr)this->state, 16);
+}
+
+void BenchThread::setupSocket(void *socket)
+{
+    int linger = 0;
+    zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+    if (this->scenario.pattern == "pubsub") {
+        // Publishers drop messages at the high water mark.
+        int hwm = 0;
+        zmq_setsockopt(socket, ZMQ_SNDHWM, &hwm, sizeof(hwm));
+        zmq_setsockopt(socket, ZMQ_RCVHWM, &hwm, sizeof(hwm));
+        int type = 0;
+        size_t len = sizeof(type);
+        zmq_getsockopt(socket, ZMQ_TYPE, &type, &len);
+        if (type == ZMQ_SUB) {
+            zmq_setsockopt(socket, ZMQ_SUBSCRIBE, "", 0);
+        }
+    }
+
+    if (this->scenario.raw) {
+        // Blocking calls of the baseline must not hang if a message is lost.
+        zmq_setsockopt(socket, ZMQ_RCVTIMEO, &this->scenario.timeout, sizeof(this->scenario.timeout));
+        zmq_setsockopt(socket, ZMQ_SNDTIMEO, &this->scenario.timeout, sizeof(this->scenario.timeout));
+    }
+}
+
+bool BenchThread::setupCompression(QZmqSocket *socket)
+{
+    QZmqCompressor::Algorithm algorithm = QZmqCompressor::None;
+    if (this->scenario.compression == "lz4") {
+        algorithm = QZmqCompressor::LZ4;
+    } else if (this->scenario.compression == "zstd") {
+        algorithm = QZmqCompressor::Zstd;
+    } else {
+        return true;
+    }
+
+    QZmqCompressor *compressor = QZmqCompressor::create(algorithm);
+    if (compressor == NULL) {
+        fprintf(stderr, "Compression is not supported: %s\n", QZmqError::getLastError(QZmqError::getLastError()));
+        return false;
+    }
+    if (!socket->setCompressor(compressor)) {
+        fprintf(stderr, "Compression cannot be used: %s\n", QZmqError::getLastError(QZmqError::getLastError()));
+        delete compressor;
+        return false;
+    }
+    return true;
+}
+
+void Receiver::run()
+{
+    if (this->scenario.raw) {
+        runRaw();
+        return;
+    }
+
+    QZmqSocket *socket = QZmqSocket::create(receiverType(this->scenario.pattern));
+    if (socket == NULL) {
+        this->failed = true;
+        this->state->bound.release(this->scenario.threads);
+        return;
+    }
+    setupSocket(socket->zmqSocket());
+    if (!setupCompression(socket)) {
+        this->failed = true;
+        this->state->bound.release(this->scenario.threads);
+        delete socket;
+        return;
+    }
+
+    if (!socket->bind(bindAddress().constData())) {
+        fprintf(stderr, "Binding failed: %s\n", QZmqError::getLastError(QZmqError::getLastError()));
+        this->failed = true;
+        this->state->bound.release(this->scenario.threads);
+        delete socket;
+        return;
+    }
+    this->state->endpoint = lastEndpoint(socket->zmqSocket());
+
+    bool echo = this->scenario.pattern == "reqrep";
+    QElapsedTimer timer;
+    QObject::connect(socket, &QZmqSocket::onMessage, socket,
+                     [this, echo, &timer](QZmqSocket *socket, QZmqMessage *msg) {
+        if (this->messages == 0) {
+            timer.start();
+        }
+        this->messages++;
+        if (echo && !socket->send(msg)) {
+            this->failed = true;
+        }
+        msg->release();
+        if (this->messages == (quint64)this->scenario.count) {
+            this->elapsed = timer.nsecsElapsed();
+            if (!echo) {
+                quit();
+            }
+        }
+    });
+
+    this->state->bound.release(this->scenario.threads);
+    exec();
+    this->stats = socket->stats();
+    delete socket;
+}
+
+void Receiver::runRaw()
+{
+    void *socket = zmq_socket(this->state->context, receiverType(this->scenario.pattern));
+    setupSocket(socket);
+    if (zmq_bind(socket, bindAddress().constData()) != 0) {
+        this->failed = true;
+        this->state->bound.release(this->scenario.threads);
+        zmq_close(socket);
+        return;
+    }
+    this->state->endpoint = lastEndpoint(socket);
+    this->state->bound.release(this->scenario.threads);
+
+    bool echo = this->scenario.pattern == "reqrep";
+    QElapsedTimer timer;
+    zmq_msg_t msg;
+    zmq_msg_init(&msg);
+    while (this->messages < (quint64)this->scenario.count) {
+        if (zmq_msg_recv(&msg, socket, 0) < 0) {
+            this->failed = true;
+            break;
+        }
+        if (this->messages == 0) {
+            timer.start();
+        }
+        this->messages++;
+        if (echo && zmq_msg_send(&msg, socket, 0) < 0) {
+            this->failed = true;
+            break;
+        }
+    }
+    this->elapsed = timer.isValid() ? timer.nsecsElapsed() : 0;
+    zmq_msg_close(&msg);
+    zmq_close(socket);
+}
+
+void Sender::run()
+{
+    this->state->bound.acquire();
+    if (this->state->endpoint.isEmpty()) {
+        this->failed = true;
+        return;
+    }
+
+    if (this->scenario.raw) {
+        runRaw();
+        return;
+    }
+
+    QZmqSocket *socket = QZmqSocket::create(senderType(this->scenario.pattern));
+    if (socket == NULL) {
+        this->failed = true;
+        return;
+    }
+    setupSocket(socket->zmqSocket());
+    if (!setupCompression(socket)) {
+        this->failed = true;
+        delete socket;
+        return;
+    }
+
+    if (!socket->connect(this->state->endpoint.toLatin1().constData())) {
+        fprintf(stderr, "Cannot connect: %s\n", QZmqError::getLastError(QZmqError::getLastError()));
+        this->failed = true;
+        delete socket;
+        return;
+    }
+
+    if (this->scenario.pattern == "pubsub") {
+        QThread::msleep(SLOW_JOINER_DELAY);
+    }
+
+    quint64 quota = this->quota();
+    if (quota == 0) {
+        delete socket;
+        return;
+    }
+
+    QElapsedTimer total;
+    QElapsedTimer roundTrip;
+    if (this->scenario.pattern == "reqrep") {
+        QObject::connect(socket, &QZmqSocket::onMessage, socket,
+                         [this, quota, &total, &roundTrip](QZmqSocket *socket, QZmqMessage *msg) {
+            this->latency.record(roundTrip.nsecsElapsed());
+            this->messages++;
+            msg->release();
+            if (this->messages == quota) {
+                this->elapsed = total.nsecsElapsed();
+                quit();
+                return;
+            }
+            roundTrip.start();
+            if (!socket->send(QZmqFrame(this->payload.constData(), this->payload.size()))) {
+                this->failed = true;
+                quit();
+            }
+        });
+
+        total.start();
+        roundTrip.start();
+        if (!socket->send(QZmqFrame(this->payload.constData(), this->payload.size()))) {
+            this->failed = true;
+            delete socket;
+            return;
+        }
+    } else {
+        // The socket queues the messages that cannot be sent right away.
+        // Sending continues from onLowWater() once the queue is full.
+        socket->setSendQueueLimits(SEND_QUEUE_LIMIT);
+        auto sendMessages = [this, socket, quota]() {
+            while (this->messages < quota) {
+                if (!socket->enqueue(QZmqFrame(this->payload.constData(), this->payload.size()))) {
+                    if (QZmqError::getLastError() != EAGAIN) {
+                        this->failed = true;
+                        quit();
+                    }
+                    break;
+                }
+                this->messages++;
+            }
+        };
+        QObject::connect(socket, &QZmqSocket::onLowWater, socket, sendMessages);
+        sendMessages();
+    }
+
+    // Throughput senders are stopped once the receiver has got all messages.
+    exec();
+    this->stats = socket->stats();
+    delete socket;
+}
+
+void Sender::runRaw()
+{
+    void *socket = zmq_socket(this->state->context, senderType(this->scenario.pattern));
+    setupSocket(socket);
+    if (zmq_connect(socket, this->state->endpoint.toLatin1().constData()) != 0) {
+        this->failed = true;
+        zmq_close(socket);
+        return;
+    }
+
+    if (this->scenario.pattern == "pubsub") {
+        QThread::msleep(SLOW_JOINER_DELAY);
+    }
+
+    bool roundTrips = this->scenario.pattern == "reqrep";
+    const QByteArray &payload = this->payload;
+    zmq_msg_t reply;
+    zmq_msg_init(&reply);
+    quint64 quota = this->quota();
+    QElapsedTimer total;
+    QElapsedTimer roundTrip;
+    total.start();
+    while (this->messages < quota) {
+        roundTrip.start();
+        if (zmq_send(socket, payload.constData(), payload.size(), 0) < 0) {
+            this->failed = true;
+            break;
+        }
+        if (roundTrips) {
+            if (zmq_msg_recv(&reply, socket, 0) < 0) {
+                this->failed = true;
+                break;
+            }
+            this->latency.record(roundTrip.nsecsElapsed());
+        }
+        this->messages++;
+    }
+    this->elapsed = total.nsecsElapsed();
+    zmq_msg_close(&reply);
+    zmq_close(socket);
+}
+
+// Run a single scenario and return its results. The receiver and the senders run in their
+// own threads. Messages are counted by the receiver, round trips are timed by the senders.
+QJsonObject runScenario(const Scenario &scenario)
+{
+    ScenarioState state;
+    state.context = scenario.raw ? zmq_ctx_new() : NULL;
+
+    Receiver receiver(scenario, &state, 0);
+    QVector<Sender*> senders;
+    for (int i = 0; i < scenario.threads; i++) {
+        senders.append(new Sender(scenario, &state, i));
+    }
+
+    if (!scenario.raw) {
+        QByteArray dispatcher = scenario.dispatcher.toLatin1();
+        setupEventDispatcher(&receiver, dispatcher.constData());
+        for (Sender *sender : senders) {
+            setupEventDispatcher(sender, dispatcher.constData());
+        }
+    }
+
+    receiver.start();
+    for (Sender *sender : senders) {
+        sender->start();
+    }
+
+    bool roundTrips = scenario.pattern == "reqrep";
+    QElapsedTimer deadline;
+    deadline.start();
+    auto remaining = [&deadline, &scenario]() {
+        return (unsigned long)qMax<qint64>(0, scenario.timeout - deadline.elapsed());
+    };
+
+    bool finished = true;
+    if (roundTrips) {
+        for (Sender *sender : senders) {
+            finished = sender->wait(remaining()) && finished;
+        }
+    } else {
+        finished = receiver.wait(remaining());
+    }
+
+    receiver.quit();
+    receiver.wait();
+    for (Sender *sender : senders) {
+        sender->quit();
+        sender->wait();
+    }
+
+    if (state.context != NULL) {
+        zmq_ctx_term(state.context);
+    }
+
+    bool ok = finished && !receiver.failed;
+    quint64 messages = roundTrips ? 0 : receiver.messages;
+    qint64 elapsed = roundTrips ? 0 : receiver.elapsed;
+    LatencyHistogram latency;
+    QZmqSocketStats sent = QZmqSocketStats();
+    for (Sender *sender : senders) {
+        sent.compressionInputBytes += sender->stats.compressionInputBytes;
+        sent.compressionOutputBytes += sender->stats.compressionOutputBytes;
+        sent.compressionTime += sender->stats.compressionTime;
+        sent.messagesSent += sender->stats.messagesSent;
+        ok = ok && !sender->failed;
+        if (roundTrips) {
+            messages += sender->messages;
+            elapsed = qMax(elapsed, sender->elapsed);
+            latency.add(sender->latency);
+        }
+    }
+    qDeleteAll(senders);
+
+    double seconds = elapsed / 1e9;
+    double rate = seconds > 0 ? messages / seconds : 0;
+
+    QJsonObject result;
+    result["pattern"] = scenario.pattern;
+    result["transport"] = scenario.transport;
+    result["size"] = scenario.size;
+    result["threads"] = scenario.threads;
+    result["api"] = scenario.raw ? "libzmq" : "qzmq";
+    result["dispatcher"] = scenario.raw ? QString("none") : scenario.dispatcher;
+    result["compression"] = scenario.raw ? QString("none") : scenario.compression;
+    result["ok"] = ok;
+    result["messages"] = (double)messages;
+    result["seconds"] = seconds;
+    result["msgs_per_sec"] = rate;
+    result["mb_per_sec"] = rate * scenario.size / 1e6;
+    if (!scenario.raw && scenario.compression != "none" && sent.compressionOutputBytes > 0) {
+        // Bandwidth saved versus CPU spent. Counted by the sockets, i.e. zero without WITH_METRICS.
+        QJsonObject compression;
+        compression["ratio"] = (double)sent.compressionInputBytes / sent.compressionOutputBytes;
+        compression["compress_us_per_msg"] = sent.compressionTime / 1000.0 / qMax<quint64>(1, sent.messagesSent);
+        compression["decompress_us_per_msg"] = receiver.stats.decompressionTime / 1000.0 /
+                                               qMax<quint64>(1, receiver.stats.framesDecompressed);
+        compression["wire_mb_per_sec"] = seconds > 0 ? sent.compressionOutputBytes / seconds / 1e6 : 0;
+        result["compression_stats"] = compression;
+    }
+    if (roundTrips) {
+        QJsonObject percentiles;
+        percentiles["mean"] = latency.mean() / 1000.0;
+        percentiles["p50"] = latency.percentile(50.0) / 1000.0;
+        percentiles["p90"] = latency.percentile(90.0) / 1000.0;
+        percentiles["p99"] = latency.percentile(99.0) / 1000.0;
+        percentiles["p99.9"] = latency.percentile(99.9) / 1000.0;
+        percentiles["max"] = latency.max() / 1000.0;
+        result["latency_us"] = percentiles;
+    }
+    return result;
+}
+
+static bool validate(const QStringList &values, const QStringList &allowed, const char *what)
+{
+    for (const QString &value : values) {
+        if (!allowed.contains(value)) {
+            fprintf(stderr, "Unknown %s: %s\n", what, value.toLocal8Bit().constData());
+            return false;
+        }
+    }
+    return !values.isEmpty();
+}
+
+static QVector<int> toInts(const QString &list)
+{
+    QVector<int> values;
+    for (const QString &value : list.split(',', QString::SkipEmptyParts)) {
+        int number = value.toInt();
+        if (number > 0) {
+            values.append(number);
+        }
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+#ifdef Q_OS_LINUX
+    const char *defaultDispatchers = "glib,unix,qzmq";
+#else
+    const char *defaultDispatchers = "glib,unix";
+#endif
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs a matrix of scenarios and prints the results as JSON.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"patterns", "socket patterns (pushpull, pubsub, reqrep)", "list", "pushpull,pubsub,reqrep"},
+        {"transports", "transports (inproc, ipc, tcp)", "list", "inproc,ipc,tcp"},
+        {"sizes", "message sizes in bytes", "list", "64,1024"},
+        {"threads", "numbers of sending threads", "list", "1"},
+        {"dispatchers", "event dispatchers (glib, unix, qzmq)", "list", defaultDispatchers},
+        {"compression", "frame compression of QZeroMQ sockets (none, lz4, zstd)", "list", "none"},
+        {"count", "messages per throughput scenario", "count", "1000000"},
+        {"roundtrips", "round trips per request-reply scenario", "count", "10000"},
+        {"timeout", "timeout of a scenario in seconds", "seconds", "30"},
+        {"no-baseline", "do not run the plain libzmq baseline"},
+        {"output", "write the results to a file instead of stdout", "file"},
+    });
+    parser.process(app);
+
+    QStringList patterns = parser.value("patterns").split(',', QString::SkipEmptyParts);
+    QStringList transports = parser.value("transports").split(',', QString::SkipEmptyParts);
+    QStringList dispatchers = parser.value("dispatchers").split(',', QString::SkipEmptyParts);
+    QStringList compressions = parser.value("compression").split(',', QString::SkipEmptyParts);
+    QVector<int> sizes = toInts(parser.value("sizes"));
+    QVector<int> threads = toInts(parser.value("threads"));
+    bool baseline = !parser.isSet("no-baseline");
+
+    if (!validate(patterns, {"pushpull", "pubsub", "reqrep"}, "pattern") ||
+        !validate(transports, {"inproc", "ipc", "tcp"}, "transport") ||
+        !validate(dispatchers, QString(defaultDispatchers).split(','), "dispatcher") ||
+        !validate(compressions, {"none", "lz4", "zstd"}, "compression") ||
+        sizes.isEmpty() || threads.isEmpty()) {
+        parser.showHelp(-1);
+    }
+
+    Scenario scenario;
+    scenario.timeout = parser.value("timeout").toInt() * 1000;
+
+    bool allOk = true;
+    QJsonArray results;
+    auto run = [&results, &allOk](const Scenario &scenario) {
+        QJsonObject result = runScenario(scenario);
+        fprintf(stderr, "%-8s %-6s %6d B %3d thr %-6s %-6s %-4s %12.0f msg/s%s\n",
+                scenario.pattern.toLatin1().constData(), scenario.transport.toLatin1().constData(),
+                scenario.size, scenario.threads, result["api"].toString().toLatin1().constData(),
+                result["dispatcher"].toString().toLatin1().constData(),
+                result["compression"].toString().toLatin1().constData(), result["msgs_per_sec"].toDouble(),
+                result["ok"].toBool() ? "" : " FAILED");
+        allOk = allOk && result["ok"].toBool();
+        return result;
+    };
+
+    for (const QString &pattern : patterns) {
+        for (const QString &transport : transports) {
+            for (int size : sizes) {
+                for (int count : threads) {
+                    scenario.pattern = pattern;
+                    scenario.transport = transport;
+                    scenario.size = size;
+                    scenario.threads = count;
+                    scenario.count = parser.value(pattern == "reqrep" ? "roundtrips" : "count").toInt();
+
+                    QJsonObject reference;
+                    if (baseline) {
+                        scenario.raw = true;
+                        scenario.dispatcher.clear();
+                        scenario.compression = "none";
+                        reference = run(scenario);
+                        results.append(reference);
+                    }
+
+                    for (const QString &dispatcher : dispatchers) {
+                        for (const QString &compression : compressions) {
+                            if (pattern == "pubsub" && compression != "none") {
+                                // Publish-subscribe sockets refuse compressors.
+                                continue;
+                            }
+                            scenario.raw = false;
+                            scenario.dispatcher = dispatcher;
+                            scenario.compression = compression;
+                            QJsonObject result = run(scenario);
+                            // Fraction of the plain libzmq rate that is achieved through QZeroMQ
+                            double referenceRate = reference["msgs_per_sec"].toDouble();
+                            if (result["ok"].toBool() && reference["ok"].toBool() && referenceRate > 0) {
+                                result["baseline_ratio"] = result["msgs_per_sec"].toDouble() / referenceRate;
+                            }
+                            results.append(result);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    int major, minor, patch;
+    zmq_version(&major, &minor, &patch);
+    QJsonObject root;
+    root["zmq_version"] = QString("%1.%2.%3").arg(major).arg(minor).arg(patch);
+    root["qt_version"] = qVersion();
+    root["results"] = results;
+    QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            fprintf(stderr, "Cannot write the results to %s\n", parser.value("output").toLocal8Bit().constData());
+            return -1;
+        }
+    } else {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    }
+
+    return allOk ? 0 : 1;
+}
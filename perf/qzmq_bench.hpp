@@ -0,0 +1,95 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_BENCH_H__
+#define __QZMQ_BENCH_H__
+
+#include "perf_histogram.hpp"
+#include <qzmq.hpp>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+
+// One cell of the benchmark matrix.
+struct Scenario
+{
+    QString pattern;        // pushpull, pubsub or reqrep
+    QString transport;      // inproc, ipc or tcp
+    QString dispatcher;     // glib, unix or qzmq
+    QString compression;    // none, lz4 or zstd
+    int size;
+    int threads;            // Number of PUSH, PUB or REQ threads
+    int count;              // Messages or round trips in total
+    int timeout;            // Milliseconds
+    bool raw;               // Plain libzmq with blocking calls, i.e. the baseline
+};
+
+// State shared by the threads of a scenario.
+struct ScenarioState
+{
+    void *context;          // Context of the baseline sockets
+    QString endpoint;       // Written by the receiver before it releases the semaphore
+    QSemaphore bound;
+};
+
+class BenchThread : public QThread
+{
+public:
+    BenchThread(const Scenario &scenario, ScenarioState *state, int index);
+
+    bool failed;
+    quint64 messages;
+    qint64 elapsed;         // Nanoseconds
+    LatencyHistogram latency;
+    QZmqSocketStats stats;
+
+protected:
+    int quota();
+    QByteArray bindAddress();
+    void setupSocket(void *socket);
+    bool setupCompression(QZmqSocket *socket);
+
+    Scenario scenario;
+    QByteArray payload;
+    ScenarioState *state;
+    int index;
+};
+
+// Binds PULL, SUB or REP and counts, or echoes, the incoming messages.
+class Receiver : public BenchThread
+{
+public:
+    using BenchThread::BenchThread;
+
+protected:
+    void run() override;
+    void runRaw();
+};
+
+// Connects PUSH, PUB or REQ and sends its share of the messages.
+class Sender : public BenchThread
+{
+public:
+    using BenchThread::BenchThread;
+
+protected:
+    void run() override;
+    void runRaw();
+};
+
+QJsonObject runScenario(const Scenario &scenario);
+
+#endif // __QZMQ_BENCH_H__
@@ -0,0 +1,232 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of the per-call costs of the hot path, in nanoseconds per operation.
+// Sockets are connected over inproc to a plain libzmq peer, so the cost of the transport
+// is as low as it gets.
+
+#include <qzmq.hpp>
+#include <zmq.h>
+#include <benchmark/benchmark.h>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <utility>
+
+// Messages are drained from the peer after this many sends.
+constexpr int DRAIN_INTERVAL = 1024;
+
+// Gives access to the protected hot path functions of QZmqSocket.
+class SocketProbe : public QZmqSocket
+{
+public:
+    static int callEvents(QZmqSocket *socket)
+    {
+        int (QZmqSocket::*function)() = &SocketProbe::events;
+        return (socket->*function)();
+    }
+
+    static void callReceiveAll(QZmqSocket *socket)
+    {
+        void (QZmqSocket::*function)() = &SocketProbe::receiveAll;
+        (socket->*function)();
+    }
+};
+
+// A QZmqSocket bound to an inproc endpoint and a plain libzmq socket connected to it.
+class SocketPair
+{
+public:
+    SocketPair(int type, int peerType)
+    {
+        static int counter = 0;
+        QByteArray address = "inproc://qzmq-microbench-" + QByteArray::number(counter++);
+        int zero = 0;
+
+        this->socket = QZmqSocket::create(type);
+        Q_ASSERT(this->socket != NULL);
+        this->socket->setOption(ZMQ_LINGER, &zero, sizeof(zero));
+        this->socket->setOption(ZMQ_SNDHWM, &zero, sizeof(zero));
+        this->socket->setOption(ZMQ_RCVHWM, &zero, sizeof(zero));
+        bool bound = this->socket->bind(address.constData());
+        Q_ASSERT(bound);
+        Q_UNUSED(bound);
+
+        this->peer = zmq_socket(QZmqContext::instance()->zmqContext(), peerType);
+        Q_ASSERT(this->peer != NULL);
+        zmq_setsockopt(this->peer, ZMQ_LINGER, &zero, sizeof(zero));
+        zmq_setsockopt(this->peer, ZMQ_SNDHWM, &zero, sizeof(zero));
+        zmq_setsockopt(this->peer, ZMQ_RCVHWM, &zero, sizeof(zero));
+        int rc = zmq_connect(this->peer, address.constData());
+        Q_ASSERT(rc == 0);
+        Q_UNUSED(rc);
+    }
+
+    ~SocketPair()
+    {
+        zmq_close(this->peer);
+        delete this->socket;
+    }
+
+    // Receive everything that the socket has sent to the peer.
+    void drain()
+    {
+        zmq_msg_t msg;
+        zmq_msg_init(&msg);
+        while (zmq_msg_recv(&msg, this->peer, ZMQ_DONTWAIT) >= 0) {
+        }
+        zmq_msg_close(&msg);
+    }
+
+    QZmqSocket *socket;
+    void *peer;
+};
+
+static void BM_MessageCreateDelete(benchmark::State &state)
+{
+    size_t size = state.range(0);
+    for (auto _ : state) {
+        QZmqMessage *msg = QZmqMessage::create(size);
+        benchmark::DoNotOptimize(msg);
+        delete msg;
+    }
+}
+BENCHMARK(BM_MessageCreateDelete)->Arg(0)->Arg(32)->Arg(1024)->Arg(65536);
+
+static void BM_MessagePoolAcquireRelease(benchmark::State &state)
+{
+    size_t size = state.range(0);
+    QZmqMessagePool *pool = QZmqMessagePool::instance();
+    for (auto _ : state) {
+        QZmqMessage *msg = pool->acquire(size);
+        benchmark::DoNotOptimize(msg);
+        msg->release();
+    }
+}
+BENCHMARK(BM_MessagePoolAcquireRelease)->Arg(0)->Arg(32)->Arg(1024)->Arg(65536);
+
+static void BM_MessageCopy(benchmark::State &state)
+{
+    QZmqMessage *src = QZmqMessage::create(state.range(0));
+    QZmqMessage *dst = QZmqMessage::create();
+    for (auto _ : state) {
+        bool copied = src->copy(dst);
+        benchmark::DoNotOptimize(copied);
+    }
+    delete dst;
+    delete src;
+}
+BENCHMARK(BM_MessageCopy)->Arg(32)->Arg(1024)->Arg(65536);
+
+static void BM_MessageMove(benchmark::State &state)
+{
+    QZmqMessage *src = QZmqMessage::create(state.range(0));
+    QZmqMessage *dst = QZmqMessage::create();
+    for (auto _ : state) {
+        bool moved = src->move(dst);
+        benchmark::DoNotOptimize(moved);
+        std::swap(src, dst);
+    }
+    delete dst;
+    delete src;
+}
+BENCHMARK(BM_MessageMove)->Arg(32)->Arg(1024)->Arg(65536);
+
+static void BM_FrameMove(benchmark::State &state)
+{
+    QZmqFrame frame(state.range(0));
+    for (auto _ : state) {
+        QZmqFrame other(std::move(frame));
+        frame = std::move(other);
+        benchmark::DoNotOptimize(frame.data());
+    }
+}
+BENCHMARK(BM_FrameMove)->Arg(32)->Arg(1024)->Arg(65536);
+
+static void BM_SocketEvents(benchmark::State &state)
+{
+    SocketPair pair(ZMQ_PAIR, ZMQ_PAIR);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SocketProbe::callEvents(pair.socket));
+    }
+}
+BENCHMARK(BM_SocketEvents);
+
+// send() includes disabling the write notifier after every successful send.
+static void BM_SocketSend(benchmark::State &state)
+{
+    SocketPair pair(ZMQ_PUSH, ZMQ_PULL);
+    size_t size = state.range(0);
+    int sent = 0;
+    for (auto _ : state) {
+        bool ok = pair.socket->send(QZmqFrame(size));
+        benchmark::DoNotOptimize(ok);
+        if (++sent == DRAIN_INTERVAL) {
+            state.PauseTiming();
+            pair.drain();
+            sent = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SocketSend)->Arg(32)->Arg(1024);
+
+// A single receiveAll() pass over the given number of pending messages,
+// either emitted one by one through onMessage or at once through onMessages.
+static void BM_SocketReceiveAll(benchmark::State &state)
+{
+    SocketPair pair(ZMQ_PULL, ZMQ_PUSH);
+    int count = state.range(0);
+    bool batch = state.range(1) != 0;
+    pair.socket->setMaximumThroughput(count);
+    pair.socket->setBatchMode(batch);
+    QObject::connect(pair.socket, &QZmqSocket::onMessage, [](QZmqSocket *socket, QZmqMessage *msg) {
+        msg->release();
+    });
+    QObject::connect(pair.socket, &QZmqSocket::onMessages, [](QZmqSocket *socket, const QVector<QZmqMessage*> &msgs) {
+        for (QZmqMessage *msg : msgs) {
+            msg->release();
+        }
+    });
+
+    QByteArray payload(64, 0);
+    QElapsedTimer timer;
+    for (auto _ : state) {
+        for (int i = 0; i < count; i++) {
+            zmq_send(pair.peer, payload.constData(), payload.size(), 0);
+        }
+        timer.start();
+        SocketProbe::callReceiveAll(pair.socket);
+        state.SetIterationTime(timer.nsecsElapsed() / 1e9);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SocketReceiveAll)
+    ->Args({1, 0})->Args({16, 0})->Args({256, 0})
+    ->Args({16, 1})->Args({256, 1})
+    ->UseManualTime();
+
+int main(int argc, char *argv[])
+{
+    // Socket notifiers need an application object.
+    QCoreApplication app(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "remote_lat.hpp"
+#include "perf_dispatcher.hpp"
 #include <cstdint>
 #include <qzmq.hpp>
 #include <zmq.h>
@@ -28,6 +29,8 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
+    parser.addOption(histogramOption());
     parser.addPositionalArgument("connect_to", "connect to");
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "roundtrip count");
@@ -46,9 +49,11 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
     this->maxMsgs = args[2].toInt();
     this->socket = NULL;
     this->watch = NULL;
+    this->histogramFile = parser.value("histogram");
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
 
     QTimer::singleShot(0, this, &App::started);
 }
@@ -78,6 +83,7 @@ void App::started()
     }
 
     this->watch = zmq_stopwatch_start();
+    this->roundTrip.start();
     QZmqMessage *msg = QZmqMessage::create(this->msgSize);
     if (!this->socket->send(msg)) {
         int error = QZmqError::getLastError();
@@ -98,8 +104,10 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         return;
     }
 
+    this->histogram.record(this->roundTrip.nsecsElapsed());
     this->msgCount++;
     if (this->msgCount < this->maxMsgs) {
+        this->roundTrip.start();
         if (!this->socket->send(msg)) {
             int error = QZmqError::getLastError();
             const char *errStr = QZmqError::getLastError(error);
@@ -115,6 +123,10 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
         uint64_t elapsed = zmq_stopwatch_stop(this->watch);
         double latency = (double)elapsed / (msgCount * 2);
         qInfo() << "Average latency:" << latency << "us";
+        this->histogram.report("Round trip latency");
+        if (!this->histogramFile.isEmpty() && !this->histogram.dump(this->histogramFile)) {
+            qCritical() << "Cannot write the histogram to" << this->histogramFile;
+        }
         delete msg;
         App::exit();
     }
@@ -158,6 +170,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
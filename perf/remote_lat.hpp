@@ -15,7 +15,9 @@
 #ifndef __REMOTE_LAT_H__
 #define __REMOTE_LAT_H__
 
+#include "perf_histogram.hpp"
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QThread>
 
 class QZmqSocket;
@@ -42,6 +44,9 @@ private:
     int msgSize;
     int maxMsgs;
     void *watch;
+    QElapsedTimer roundTrip;
+    LatencyHistogram histogram;
+    QString histogramFile;
 };
 
 #endif // __REMOTE_LAT_H__
\ No newline at end of file
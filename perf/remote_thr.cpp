@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "remote_thr.hpp"
+#include "perf_dispatcher.hpp"
 #include <cstdint>
 #include <qzmq.hpp>
 #include <zmq.h>
@@ -23,11 +24,14 @@
 #include <QCommandLineParser>
 #include <QString>
 
+constexpr int SEND_QUEUE_LIMIT = 1000;
+
 App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
 {
 
     QCommandLineParser parser;
     parser.addHelpOption();
+    parser.addOption(dispatcherOption());
     parser.addPositionalArgument("connect_to", "connect to");
     parser.addPositionalArgument("size", "message size");
     parser.addPositionalArgument("count", "roundtrip count");
@@ -45,11 +49,11 @@ App::App(int &argc, char **argv) : QCoreApplication(argc, argv)
     this->msgSize = args[1].toInt();
     this->maxMsgs = args[2].toInt();
     this->socket = NULL;
-    this->msgQueued = NULL;
     this->watch = NULL;
 
     qInfo() << "Message size :" << this->msgSize;
     qInfo() << "Message count:" << this->maxMsgs;
+    qInfo() << "Dispatcher   :" << parser.value("dispatcher");
 
     QTimer::singleShot(0, this, &App::started);
 }
@@ -68,7 +72,9 @@ void App::started()
     Q_ASSERT(this->socket != NULL);
     connect(this->socket, &QZmqSocket::onMessage, this, &App::onMessage);
     connect(this->socket, &QZmqSocket::onReadyToSend, this, &App::onReadyToSend);
+    connect(this->socket, &QZmqSocket::onLowWater, this, &App::onLowWater);
     connect(this->socket, &QZmqSocket::onError, this, &App::onError);
+    this->socket->setSendQueueLimits(SEND_QUEUE_LIMIT);
 
     if(!this->socket->connect(this->connectTo.toStdString().c_str())) {
         int error = QZmqError::getLastError();
@@ -79,22 +85,29 @@ void App::started()
     }
 
     this->msgCount = 0;
+    sendMessages();
+    if (this->msgCount == this->maxMsgs && this->socket->sendQueueSize() == 0) {
+        App::exit();
+    }
+}
+
+void App::sendMessages()
+{
+    // The socket queues the messages that cannot be sent right away.
+    // Sending continues from onLowWater() once the queue is full.
     while(this->msgCount < this->maxMsgs) {
-        QZmqMessage *msg = QZmqMessage::create(this->msgSize);
-        if (!this->socket->send(msg)) {
-            int error = QZmqError::getLastError();
+        QZmqMessage *msg = QZmqMessagePool::instance()->acquire(this->msgSize);
+        bool queued = this->socket->enqueue(msg);
+        int error = QZmqError::getLastError();
+        msg->release();
+        if (!queued) {
             if (error != EAGAIN) {
                 const char *errStr = QZmqError::getLastError(error);
-                qCritical() << "Sending failed:" << QZmqError::getLastError() << "-" << errStr;
-                delete msg;
-            } else {
-                this->msgQueued = msg;
+                qCritical() << "Sending failed:" << error << "-" << errStr;
             }
             break;
-        } else {
-            delete msg;
-            this->msgCount++;
         }
+        this->msgCount++;
     }
 }
 
@@ -105,35 +118,17 @@ void App::onMessage(QZmqSocket *socket, QZmqMessage *msg)
 
 void App::onReadyToSend(QZmqSocket *socket)
 {
-    while(this->msgCount < this->maxMsgs) {
-        QZmqMessage *msg = NULL;
-        if (this->msgQueued != NULL) {
-            msg = this->msgQueued;
-            this->msgQueued = NULL;
-        } else {
-            msg = QZmqMessage::create(this->msgSize);
-        }
-        if (!this->socket->send(msg)) {
-            int error = QZmqError::getLastError();
-            if (error != EAGAIN) {
-                const char *errStr = QZmqError::getLastError(error);
-                qCritical() << "Sending failed:" << QZmqError::getLastError() << "-" << errStr;
-                delete msg;
-            } else {
-                this->msgQueued = msg;
-            }
-            break;
-        } else {
-            delete msg;
-            this->msgCount++;
-        }
-    }
-
+    // Emitted once the send queue is drained.
     if (this->msgCount == this->maxMsgs) {
         App::exit();
     }
 }
 
+void App::onLowWater(QZmqSocket *socket)
+{
+    sendMessages();
+}
+
 void App::onError(QZmqSocket *socket, int error)
 {
     qCritical() << "Socket error:" << QZmqError::getLastError(error);
@@ -167,6 +162,9 @@ void customMessageOutput(QtMsgType type, const QMessageLogContext& context, cons
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler(customMessageOutput);
+    if (!setupEventDispatcher(dispatcherName(argc, argv))) {
+        return -1;
+    }
     App app(argc, argv);
 
     return app.exec();
@@ -32,12 +32,14 @@ public:
 private slots:
     void onMessage(QZmqSocket *socket, QZmqMessage *msg);
     void onReadyToSend(QZmqSocket *socket);
+    void onLowWater(QZmqSocket *socket);
     void onError(QZmqSocket *socket, int error);
     void started();
 
 private:
+    void sendMessages();
+
     QZmqSocket *socket;
-    QZmqMessage *msgQueued;
     QString connectTo;
     int msgCount;
     int msgSize;
@@ -19,6 +19,24 @@
 #include "qzmqerror.hpp"
 #include "qzmqcontext.hpp"
 #include "qzmqmessage.hpp"
+#include "qzmqmessagepool.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqsender.hpp"
+#include "qzmqworkerpool.hpp"
+#include "qzmqproxy.hpp"
+#include "qzmqmonitor.hpp"
+#include "qzmqsocketmetrics.hpp"
+#include "qzmqrequester.hpp"
+#include "qzmqbytearrayview.hpp"
+#include "qzmqcompressor.hpp"
+#include "qzmqcoalescer.hpp"
 #include "qzmqsocket.hpp"
+#include "qzmqcodec.hpp"
+#include "qzmqreactor.hpp"
+#include "qzmqasync.hpp"
+#ifdef __linux__
+#include "qzmqeventdispatcher.hpp"
+#endif
 
 #endif // __QT_ZMQ_H__
\ No newline at end of file
@@ -0,0 +1,306 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_ASYNC_H__
+#define __QZMQ_ASYNC_H__
+
+// C++20 coroutine support. This header is empty unless the compiler supports coroutines.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include "qzmqcommon.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqmessage.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqerror.hpp"
+#include <zmq.h>
+#include <QObject>
+#include <QVector>
+#include <cerrno>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#define QZMQ_HAS_COROUTINES
+
+QZMQ_BEGIN_NAMESPACE
+
+/**
+ * @brief   Return type of fire-and-forget coroutines. The coroutine starts right away
+ *          and its frame is freed when it finishes.
+ */
+struct QZmqTask
+{
+    struct promise_type
+    {
+        QZmqTask get_return_object() noexcept { return QZmqTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief   Awaitable receive and send operations on top of a QZmqSocket.
+ *          A suspended coroutine is resumed inline from QZmqSocket::onMessage(),
+ *          QZmqSocket::onMessages() or QZmqSocket::onReadyToSend(), i.e. by the event loop
+ *          of the thread that owns the socket. Awaiting does not allocate once the queue
+ *          of received messages has grown to its working size.
+ *
+ *          At most one coroutine may wait for receiving and one for sending at a time.
+ *          The socket must outlive this object. Multipart mode is not supported.
+ *
+ *          Messages that arrive while no coroutine is waiting are kept until they are
+ *          awaited. Once the receive limit is reached, receiving on the socket is paused
+ *          (QZmqSocket::setReceivePaused()) until the coroutine catches up, so ØMQ applies
+ *          its high water mark to the peers. A single pass of the socket may overshoot the
+ *          limit by up to QZmqSocket::maximumThroughput() messages.
+ *
+ * @code
+ *  QZmqTask echo(QZmqAsyncSocket &socket)
+ *  {
+ *      while (QZmqMessage *msg = co_await socket.receiveAsync()) {
+ *          co_await socket.sendAsync(msg);
+ *          msg->release();
+ *      }
+ *  }
+ * @endcode
+ */
+class QZmqAsyncSocket
+{
+public:
+    class ReceiveAwaiter
+    {
+    public:
+        explicit ReceiveAwaiter(QZmqAsyncSocket *owner) : owner(owner) {}
+        bool await_ready() const noexcept { return this->owner->count > 0 || this->owner->closed; }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            Q_ASSERT(!this->owner->receiveWaiter);
+            this->owner->receiveWaiter = handle;
+        }
+        // Returns the received message, which is owned by the caller, or NULL if the
+        // QZmqAsyncSocket was destroyed while waiting.
+        QZmqMessage* await_resume() noexcept { return this->owner->takeMessage(); }
+
+    private:
+        QZmqAsyncSocket *owner;
+    };
+
+    class SendAwaiter
+    {
+    public:
+        SendAwaiter(QZmqAsyncSocket *owner, QZmqFrame &&frame, int flags)
+            : owner(owner), frame(std::move(frame)), flags(flags), sent(false), error(0) {}
+        SendAwaiter(SendAwaiter &&other) noexcept
+            : owner(other.owner), frame(std::move(other.frame)), flags(other.flags),
+              sent(other.sent), error(other.error) {}
+
+        // Try to send right away. Suspend only if the socket cannot accept the frame.
+        bool await_ready() noexcept
+        {
+            if (this->owner->closed) {
+                this->error = ETERM;
+                return true;
+            }
+            return trySend();
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            Q_ASSERT(this->owner->sendWaiter == NULL);
+            this->handle = handle;
+            this->owner->sendWaiter = this;
+        }
+        // Returns true if the frame is sent. Otherwise, QZmqError::getLastError() gives the error.
+        bool await_resume() noexcept
+        {
+            if (!this->sent) {
+                errno = this->error;
+            }
+            return this->sent;
+        }
+
+    private:
+        friend class QZmqAsyncSocket;
+        bool trySend() noexcept
+        {
+            if (this->owner->target->send(std::move(this->frame), this->flags)) {
+                this->sent = true;
+                return true;
+            }
+            this->error = QZmqError::getLastError();
+            return this->error != EAGAIN;
+        }
+
+        QZmqAsyncSocket *owner;
+        QZmqFrame frame;
+        int flags;
+        bool sent;
+        int error;
+        std::coroutine_handle<> handle;
+    };
+
+    explicit QZmqAsyncSocket(QZmqSocket *socket, int receiveLimit=1024) : target(socket)
+    {
+        Q_ASSERT(socket != NULL);
+        this->head = 0;
+        this->count = 0;
+        this->limit = qMax(1, receiveLimit);
+        this->paused = false;
+        this->closed = false;
+        this->sendWaiter = NULL;
+        this->received.resize(16);
+
+        this->connections[0] = QObject::connect(socket, &QZmqSocket::onMessage, socket,
+                                                [this](QZmqSocket*, QZmqMessage *msg) {
+            pushMessage(msg);
+            resumeReceiver();
+        });
+        this->connections[1] = QObject::connect(socket, &QZmqSocket::onMessages, socket,
+                                                [this](QZmqSocket*, const QVector<QZmqMessage*> &msgs) {
+            for (QZmqMessage *msg : msgs) {
+                pushMessage(msg);
+            }
+            resumeReceiver();
+        });
+        this->connections[2] = QObject::connect(socket, &QZmqSocket::onReadyToSend, socket,
+                                                [this](QZmqSocket*) {
+            resumeSender(false);
+        });
+    }
+
+    // Waiting coroutines are resumed with NULL message and ETERM error respectively.
+    ~QZmqAsyncSocket()
+    {
+        for (const QMetaObject::Connection &connection : this->connections) {
+            QObject::disconnect(connection);
+        }
+        this->closed = true;
+        resumeSender(true);
+        resumeReceiver();
+        while (this->count > 0) {
+            takeMessage()->release();
+        }
+        if (this->paused) {
+            this->target->setReceivePaused(false);
+        }
+    }
+
+    QZmqSocket* socket() { return this->target; }
+
+    // Maximum number of received messages kept for coroutines before receiving is paused.
+    int receiveLimit() { return this->limit; }
+    void setReceiveLimit(int limit)
+    {
+        this->limit = qMax(1, limit);
+        updatePaused();
+    }
+
+    ReceiveAwaiter receiveAsync() { return ReceiveAwaiter(this); }
+
+    SendAwaiter sendAsync(QZmqFrame &&frame, int flags=ZMQ_DONTWAIT)
+    {
+        return SendAwaiter(this, std::move(frame), flags);
+    }
+
+    // The content of the message is moved into the awaiter. The caller still owns the message.
+    SendAwaiter sendAsync(QZmqMessage *msg, int flags=ZMQ_DONTWAIT)
+    {
+        QZmqFrame frame;
+        zmq_msg_move(frame.zmqMsg(), msg->zmqMsg());
+        return SendAwaiter(this, std::move(frame), flags);
+    }
+
+protected:
+    Q_DISABLE_COPY(QZmqAsyncSocket);
+
+    // Received messages are kept in a ring buffer that grows up to about the receive limit.
+    void pushMessage(QZmqMessage *msg)
+    {
+        if (this->count == this->received.size()) {
+            QVector<QZmqMessage*> grown(this->received.size() * 2);
+            for (int i = 0; i < this->count; i++) {
+                grown[i] = this->received[(this->head + i) % this->received.size()];
+            }
+            this->received.swap(grown);
+            this->head = 0;
+        }
+        this->received[(this->head + this->count) % this->received.size()] = msg;
+        this->count++;
+        updatePaused();
+    }
+
+    QZmqMessage* takeMessage()
+    {
+        if (this->count == 0) {
+            return NULL;
+        }
+        QZmqMessage *msg = this->received[this->head];
+        this->head = (this->head + 1) % this->received.size();
+        this->count--;
+        updatePaused();
+        return msg;
+    }
+
+    // Stop reading from the socket while the coroutine is behind by the receive limit.
+    void updatePaused()
+    {
+        bool full = !this->closed && this->count >= this->limit;
+        if (full != this->paused) {
+            this->paused = full;
+            this->target->setReceivePaused(full);
+        }
+    }
+
+    void resumeReceiver()
+    {
+        if (this->receiveWaiter && (this->count > 0 || this->closed)) {
+            std::coroutine_handle<> handle = std::exchange(this->receiveWaiter, nullptr);
+            handle.resume();
+        }
+    }
+
+    void resumeSender(bool cancel)
+    {
+        SendAwaiter *waiter = this->sendWaiter;
+        if (waiter == NULL) {
+            return;
+        }
+        if (cancel) {
+            waiter->error = ETERM;
+        } else if (!waiter->trySend()) {
+            // Still EAGAIN. The socket emits onReadyToSend() again once it is writable.
+            return;
+        }
+        this->sendWaiter = NULL;
+        waiter->handle.resume();
+    }
+
+    QZmqSocket *target;
+    QMetaObject::Connection connections[3];
+    QVector<QZmqMessage*> received;
+    int head;
+    int count;
+    int limit;
+    bool paused;
+    bool closed;
+    std::coroutine_handle<> receiveWaiter;
+    SendAwaiter *sendWaiter;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __cpp_impl_coroutine
+
+#endif // __QZMQ_ASYNC_H__
@@ -0,0 +1,114 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqbytearrayview.hpp"
+#include <zmq.h>
+#include <QSharedData>
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqByteArrayViewData : public QSharedData
+{
+public:
+    QZmqByteArrayViewData()
+    {
+        zmq_msg_init(&this->msg);
+    }
+
+    ~QZmqByteArrayViewData()
+    {
+        zmq_msg_close(&this->msg);
+    }
+
+    zmq_msg_t msg;
+};
+
+/**
+ * @brief   Construct an empty view.
+ */
+QZmqByteArrayView::QZmqByteArrayView()
+{
+    this->ptr = "";
+    this->len = 0;
+}
+
+/**
+ * @brief   Construct a view of the content of a ØMQ message.
+ *          The content is shared by reference counting (refer to the documentation of
+ *          zmq_msg_copy()), so the message can be reused or closed afterwards.
+ * 
+ * @param msg   A pointer to the message.
+ */
+QZmqByteArrayView::QZmqByteArrayView(zmq_msg_t *msg)
+{
+    this->ptr = "";
+    this->len = 0;
+
+    QZmqByteArrayViewData *data = new QZmqByteArrayViewData();
+    if (zmq_msg_copy(&data->msg, msg) != 0) {
+        delete data;
+        return;
+    }
+
+    this->d = data;
+    this->ptr = static_cast<const char*>(zmq_msg_data(&data->msg));
+    this->len = zmq_msg_size(&data->msg);
+}
+
+/**
+ * @brief   Copy constructor. Both views share the same content.
+ * 
+ * @param other The view to be copied.
+ */
+QZmqByteArrayView::QZmqByteArrayView(const QZmqByteArrayView &other) :
+    d(other.d), ptr(other.ptr), len(other.len)
+{
+
+}
+
+/**
+ * @brief   Copy assignment. Both views share the same content.
+ * 
+ * @param other The view to be copied.
+ * @return QZmqByteArrayView&   Reference to this view.
+ */
+QZmqByteArrayView& QZmqByteArrayView::operator=(const QZmqByteArrayView &other)
+{
+    this->d = other.d;
+    this->ptr = other.ptr;
+    this->len = other.len;
+    return *this;
+}
+
+/**
+ * @brief   Destroy the view. The content is released with the last view.
+ */
+QZmqByteArrayView::~QZmqByteArrayView()
+{
+
+}
+
+/**
+ * @brief   Returns a byte array that refers to the content without copying it.
+ *          Refer to the documentation of QByteArray::fromRawData().
+ *          @note The byte array is valid only as long as this view (or a copy of it) exists.
+ * 
+ * @return QByteArray   A byte array that refers to the content.
+ */
+QByteArray QZmqByteArrayView::toByteArray() const
+{
+    return QByteArray::fromRawData(this->ptr, (int)this->len);
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,59 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_BYTE_ARRAY_VIEW_H__
+#define __QZMQ_BYTE_ARRAY_VIEW_H__
+
+#include "qzmqcommon.hpp"
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+struct zmq_msg_t;
+
+QZMQ_BEGIN_NAMESPACE
+
+// Read-only view of the content of a received message.
+// The content is shared with libzmq instead of being copied, and stays alive as long as
+// any copy of the view exists.
+class QZmqByteArrayViewData;
+class QZMQ_API QZmqByteArrayView
+{
+public:
+    QZmqByteArrayView();
+    QZmqByteArrayView(const QZmqByteArrayView &other);
+    QZmqByteArrayView& operator=(const QZmqByteArrayView &other);
+    ~QZmqByteArrayView();
+    QByteArray toByteArray() const;
+    inline const char* data() const { return this->ptr; }
+    inline size_t size() const { return this->len; }
+    inline bool isEmpty() const { return this->len == 0; }
+#if __cplusplus >= 201703L
+    inline std::string_view toStringView() const { return std::string_view(this->ptr, this->len); }
+#endif
+
+protected:
+    friend class QZmqMessage;
+    friend class QZmqFrame;
+    explicit QZmqByteArrayView(zmq_msg_t *msg);
+    QExplicitlySharedDataPointer<QZmqByteArrayViewData> d;
+    const char *ptr;
+    size_t len;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_BYTE_ARRAY_VIEW_H__
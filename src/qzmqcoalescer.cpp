@@ -0,0 +1,233 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqcoalescer.hpp"
+#include <QtEndian>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr size_t LENGTH_PREFIX_SIZE = sizeof(quint32);
+
+/**
+ * @brief   Construct a new QZmqCoalescer::QZmqCoalescer object.
+ *          @sa QZmqCoalescer::setLimits()
+ */
+QZmqCoalescer::QZmqCoalescer(int messages, int bytes, int delay)
+{
+    this->buffer = NULL;
+    this->capacity = 0;
+    this->used = 0;
+    this->count = 0;
+    this->payload = 0;
+    this->sealedCount = 0;
+    this->sealedPayload = 0;
+    this->sealed = false;
+    setLimits(messages, bytes, delay);
+}
+
+/**
+ * @brief   Destroy the QZmqCoalescer::QZmqCoalescer object.
+ *          Messages that are not sent yet are discarded.
+ */
+QZmqCoalescer::~QZmqCoalescer()
+{
+    free(this->buffer);
+    this->buffer = NULL;
+}
+
+/**
+ * @brief   Set when a batch is due. The limits of the batch that is being built
+ *          apply from its next message on.
+ *
+ * @param messages  Maximum number of messages in a batch.
+ * @param bytes     Batch size in bytes that makes the batch due. A message that does not
+ *                  fit into the current batch starts a new one. Larger messages are sent
+ *                  in a batch of their own.
+ * @param delay     Maximum time in microseconds that a message waits in the batch.
+ */
+void QZmqCoalescer::setLimits(int messages, int bytes, int delay)
+{
+    this->maxMessages = qMax(1, messages);
+    this->maxBytes = qMax(1, bytes);
+    this->maxDelay = qMax(0, delay);
+}
+
+/**
+ * @brief   Check if there is nothing to be sent.
+ *
+ * @return true     If the batch is empty and no sealed batch is pending.
+ * @return false    Otherwise.
+ */
+bool QZmqCoalescer::isEmpty()
+{
+    return this->count == 0 && !this->sealed;
+}
+
+/**
+ * @brief   Check if a sealed batch is waiting to be sent.
+ */
+bool QZmqCoalescer::isSealed()
+{
+    return this->sealed;
+}
+
+/**
+ * @brief   Check if a message of the given size can be added to the current batch.
+ *          There is no room while a sealed batch is pending.
+ *
+ * @param size  Size of the message in bytes.
+ */
+bool QZmqCoalescer::hasRoom(size_t size)
+{
+    if (this->sealed) {
+        return false;
+    }
+    if (this->count == 0) {
+        return true;
+    }
+    return this->count < this->maxMessages &&
+           this->used + LENGTH_PREFIX_SIZE + size <= this->capacity;
+}
+
+/**
+ * @brief   Copy a message into the current batch. QZmqCoalescer::hasRoom() must be true.
+ *
+ * @param data  Content of the message.
+ * @param size  Size of the message in bytes.
+ * @return true     If the operation is successful.
+ * @return false    If the buffer cannot be allocated. The error code is set to ENOMEM.
+ */
+bool QZmqCoalescer::append(const void *data, size_t size)
+{
+    Q_ASSERT(hasRoom(size));
+
+    if (this->buffer == NULL) {
+        this->capacity = qMax<size_t>(this->maxBytes, LENGTH_PREFIX_SIZE + size);
+        this->buffer = static_cast<char*>(malloc(this->capacity));
+        if (this->buffer == NULL) {
+            errno = ENOMEM;
+            return false;
+        }
+    }
+
+    char *dst = this->buffer + this->used;
+    qToLittleEndian<quint32>(static_cast<quint32>(size), dst);
+    memcpy(dst + LENGTH_PREFIX_SIZE, data, size);
+    if (this->count == 0) {
+        this->age.start();
+    }
+    this->used += LENGTH_PREFIX_SIZE + size;
+    this->count++;
+    this->payload += size;
+    return true;
+}
+
+/**
+ * @brief   Check if the current batch has to be sent, i.e. one of the limits is reached.
+ */
+bool QZmqCoalescer::isDue()
+{
+    if (this->count == 0) {
+        return false;
+    }
+    return this->count >= this->maxMessages || this->used >= static_cast<size_t>(this->maxBytes) ||
+           this->age.nsecsElapsed() >= this->maxDelay * 1000LL;
+}
+
+/**
+ * @brief   Returns the time until the current batch is due.
+ *
+ * @return int  Milliseconds, rounded down. 0 for delays below a millisecond.
+ */
+int QZmqCoalescer::timeout()
+{
+    qint64 remaining = this->maxDelay - this->age.nsecsElapsed() / 1000;
+    return static_cast<int>(qMax<qint64>(0, remaining / 1000));
+}
+
+/**
+ * @brief   Turn the current batch into a frame to be sent. The buffer is handed over to
+ *          the frame and a new buffer is allocated for the next batch.
+ *          The frame stays with the coalescer until QZmqCoalescer::discard() is called.
+ *
+ * @return QZmqFrame*   The sealed batch or NULL if there is nothing to be sent or if the
+ *                      frame cannot be created. Use QZmqCoalescer::isEmpty() to tell apart.
+ */
+QZmqFrame* QZmqCoalescer::seal()
+{
+    if (this->sealed) {
+        return &this->frame;
+    }
+    if (this->count == 0) {
+        return NULL;
+    }
+    if (!this->frame.rebuild(this->buffer, this->used, &QZmqCoalescer::freeBuffer, NULL)) {
+        return NULL;
+    }
+    this->sealedCount = this->count;
+    this->sealedPayload = this->payload;
+    this->buffer = NULL;
+    this->capacity = 0;
+    this->used = 0;
+    this->count = 0;
+    this->payload = 0;
+    this->sealed = true;
+    return &this->frame;
+}
+
+/**
+ * @brief   Returns the number of messages in the sealed batch.
+ */
+int QZmqCoalescer::sealedMessages()
+{
+    return this->sealed ? this->sealedCount : 0;
+}
+
+/**
+ * @brief   Returns the number of messages that are not sent yet, sealed or not.
+ */
+int QZmqCoalescer::pendingMessages()
+{
+    return sealedMessages() + this->count;
+}
+
+/**
+ * @brief   Returns the size of the messages in the sealed batch without the length prefixes.
+ */
+size_t QZmqCoalescer::sealedBytes()
+{
+    return this->sealed ? this->sealedPayload : 0;
+}
+
+/**
+ * @brief   Forget the sealed batch, e.g. once it is sent.
+ */
+void QZmqCoalescer::discard()
+{
+    this->frame.rebuild();
+    this->sealed = false;
+    this->sealedCount = 0;
+    this->sealedPayload = 0;
+}
+
+void QZmqCoalescer::freeBuffer(void *data, void *hint)
+{
+    Q_UNUSED(hint);
+    free(data);
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,66 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_COALESCER_H__
+#define __QZMQ_COALESCER_H__
+
+#include "qzmqcommon.hpp"
+#include "qzmqframe.hpp"
+#include <QElapsedTimer>
+
+QZMQ_BEGIN_NAMESPACE
+
+// Packs small messages into a single batch frame for QZmqSocket in coalescing mode.
+// A batch is a sequence of messages, each prefixed with its 32-bit length in little endian.
+// The batch is built in a heap buffer that is handed over to ØMQ without copying.
+class QZMQ_API QZmqCoalescer
+{
+public:
+    QZmqCoalescer(int messages, int bytes, int delay);
+    ~QZmqCoalescer();
+    void setLimits(int messages, int bytes, int delay);
+    bool isEmpty();
+    bool isSealed();
+    bool hasRoom(size_t size);
+    bool append(const void *data, size_t size);
+    bool isDue();
+    int timeout();
+    QZmqFrame* seal();
+    int sealedMessages();
+    int pendingMessages();
+    size_t sealedBytes();
+    void discard();
+
+protected:
+    Q_DISABLE_COPY(QZmqCoalescer);
+    static void freeBuffer(void *data, void *hint);
+
+    int maxMessages;
+    int maxBytes;
+    int maxDelay;           // Microseconds
+    char *buffer;
+    size_t capacity;
+    size_t used;
+    int count;
+    size_t payload;         // Size of the messages without the length prefixes
+    int sealedCount;
+    size_t sealedPayload;
+    QElapsedTimer age;      // Started with the first message of the batch
+    QZmqFrame frame;        // A sealed batch that is not sent yet
+    bool sealed;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_COALESCER_H__
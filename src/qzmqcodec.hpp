@@ -0,0 +1,265 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_CODEC_H__
+#define __QZMQ_CODEC_H__
+
+#include "qzmqcommon.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmessage.hpp"
+#include "qzmqsocket.hpp"
+#include <QObject>
+#include <QMetaMethod>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+QZMQ_BEGIN_NAMESPACE
+
+// Encodes values of type T into frames and decodes them from received messages.
+// Values are encoded in the byte order of the host.
+//
+// Trivially copyable types are handled by the primary template. On receive, such values
+// are read in place from the message if the content is suitably aligned.
+//
+// Other types, e.g. records with variable length fields, need a specialization that
+// inherits QZmqCodecBase and provides:
+//   static size_t size(const T &value);                         // Encoded size in bytes
+//   static void write(const T &value, char *dst);               // Write exactly size(value) bytes
+//   static bool read(const char *src, size_t size, T &value);   // false if the content is malformed
+// QZmqCodecWriter and QZmqCodecReader help with length-prefixed fields.
+struct QZmqCodecBase
+{
+    static constexpr bool inPlace = false;
+};
+
+template<typename T>
+struct QZmqCodec
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "QZmqCodec must be specialized for types that are not trivially copyable");
+
+    static constexpr bool inPlace = true;
+
+    static size_t size(const T &value)
+    {
+        Q_UNUSED(value);
+        return sizeof(T);
+    }
+
+    static void write(const T &value, char *dst)
+    {
+        memcpy(dst, &value, sizeof(T));
+    }
+
+    static bool read(const char *src, size_t size, T &value)
+    {
+        if (size != sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, src, sizeof(T));
+        return true;
+    }
+};
+
+// Writes fields one after another into a buffer of the exact encoded size.
+class QZmqCodecWriter
+{
+public:
+    explicit QZmqCodecWriter(char *dst) : pos(dst) {}
+
+    template<typename V>
+    inline void put(const V &value)
+    {
+        static_assert(std::is_trivially_copyable<V>::value, "Fields must be trivially copyable");
+        memcpy(this->pos, &value, sizeof(V));
+        this->pos += sizeof(V);
+    }
+
+    // A 32-bit length followed by the bytes.
+    inline void putBytes(const void *data, quint32 size)
+    {
+        put(size);
+        memcpy(this->pos, data, size);
+        this->pos += size;
+    }
+
+    static inline size_t bytesSize(quint32 size) { return sizeof(quint32) + size; }
+
+protected:
+    char *pos;
+};
+
+// Reads fields one after another with bounds checks. Variable length fields are not copied.
+class QZmqCodecReader
+{
+public:
+    QZmqCodecReader(const char *src, size_t size) : pos(src), end(src + size) {}
+
+    template<typename V>
+    inline bool get(V &value)
+    {
+        static_assert(std::is_trivially_copyable<V>::value, "Fields must be trivially copyable");
+        if ((size_t)(this->end - this->pos) < sizeof(V)) {
+            return false;
+        }
+        memcpy(&value, this->pos, sizeof(V));
+        this->pos += sizeof(V);
+        return true;
+    }
+
+    // The returned pointer refers to the content of the message.
+    inline bool getBytes(const char *&data, quint32 &size)
+    {
+        if (!get(size) || (size_t)(this->end - this->pos) < size) {
+            return false;
+        }
+        data = this->pos;
+        this->pos += size;
+        return true;
+    }
+
+    inline bool atEnd() const { return this->pos == this->end; }
+
+protected:
+    const char *pos;
+    const char *end;
+};
+
+/**
+ * @brief   Encode a value into a frame. The frame is allocated with the exact encoded
+ *          size and the value is written into it directly.
+ *
+ * @param value     The value to be encoded.
+ * @param frame     The frame to encode into.
+ * @return true     If the operation is successful.
+ * @return false    If the frame cannot be allocated.
+ */
+template<typename T>
+bool qzmqEncode(const T &value, QZmqFrame &frame)
+{
+    size_t size = QZmqCodec<T>::size(value);
+    if (!frame.rebuild(size)) {
+        return false;
+    }
+    QZmqCodec<T>::write(value, static_cast<char*>(frame.data()));
+    return true;
+}
+
+/**
+ * @brief   Decode a value from a frame.
+ *
+ * @return false    If the content is malformed. EPROTO is reported.
+ */
+template<typename T>
+bool qzmqDecode(QZmqFrame &frame, T &value)
+{
+    if (!QZmqCodec<T>::read(static_cast<const char*>(frame.data()), frame.size(), value)) {
+        errno = EPROTO;
+        return false;
+    }
+    return true;
+}
+
+namespace QZmqCodecPrivate {
+
+// Call the handler with a reference into the message if possible, otherwise with a decoded copy.
+template<typename T, typename Handler>
+bool deliver(const char *data, size_t size, Handler &handler, QZmqSocket *socket, std::true_type)
+{
+    if (size != sizeof(T)) {
+        return false;
+    }
+    if (reinterpret_cast<quintptr>(data) % alignof(T) == 0) {
+        handler(socket, *reinterpret_cast<const T*>(data));
+    } else {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        handler(socket, static_cast<const T&>(value));
+    }
+    return true;
+}
+
+template<typename T, typename Handler>
+bool deliver(const char *data, size_t size, Handler &handler, QZmqSocket *socket, std::false_type)
+{
+    T value;
+    if (!QZmqCodec<T>::read(data, size, value)) {
+        return false;
+    }
+    handler(socket, static_cast<const T&>(value));
+    return true;
+}
+
+} // namespace QZmqCodecPrivate
+
+/**
+ * @brief   Deliver the received messages of the socket as values of type T.
+ *          The handler is called as handler(QZmqSocket *socket, const T &value).
+ *          The value may refer to the content of the message, which is released once the
+ *          handler returns. Malformed messages are dropped and reported through
+ *          QZmqSocket::onError() with EPROTO.
+ *          The handler is called in the context of the given object, like QObject::connect().
+ *          @note The connection takes the received messages over and releases them. So, it
+ *          must be the only receiver of QZmqSocket::onMessage(); no other slot, typed handler
+ *          or QZmqAsyncSocket may be connected to the socket. Batch, multipart and coalescing
+ *          modes are not supported since they do not deliver through QZmqSocket::onMessage()
+ *          alone.
+ *
+ * @param context   Context object of the connection.
+ * @param handler   Function to be called with each decoded value.
+ * @return QMetaObject::Connection  The connection to QZmqSocket::onMessage().
+ */
+template<typename T, typename Handler>
+QMetaObject::Connection QZmqSocket::onTypedMessage(const QObject *context, Handler handler)
+{
+    Q_ASSERT(!this->batchEnabled && !this->multipartEnabled && this->coalescer == NULL);
+    Q_ASSERT(!isSignalConnected(QMetaMethod::fromSignal(&QZmqSocket::onMessage)));
+    Q_ASSERT(!isSignalConnected(QMetaMethod::fromSignal(&QZmqSocket::onMessages)));
+    return QObject::connect(this, &QZmqSocket::onMessage, context,
+                            [handler](QZmqSocket *socket, QZmqMessage *msg) mutable {
+        const char *data = static_cast<const char*>(msg->data());
+        bool ok = QZmqCodecPrivate::deliver<T>(data, msg->size(), handler, socket,
+                                               std::integral_constant<bool, QZmqCodec<T>::inPlace>());
+        msg->release();
+        if (!ok) {
+            emit socket->onError(socket, EPROTO);
+        }
+    });
+}
+
+/**
+ * @brief   Encode a value straight into a new frame and send it.
+ *          @sa QZmqSocket::send(QZmqFrame&&, int)
+ *
+ * @param value     The value to be sent.
+ * @param flags     Refer to the documentation of zmq_msg_send().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+template<typename T>
+bool QZmqSocket::sendTyped(const T &value, int flags)
+{
+    QZmqFrame frame;
+    if (!qzmqEncode(value, frame)) {
+        return false;
+    }
+    return send(std::move(frame), flags);
+}
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_CODEC_H__
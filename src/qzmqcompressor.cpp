@@ -0,0 +1,508 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqcompressor.hpp"
+#include "qzmqerror.hpp"
+#include <QtEndian>
+#include <cerrno>
+#include <cstring>
+#ifdef QZMQ_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef QZMQ_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr size_t DEFAULT_COMPRESSION_THRESHOLD = 512;
+constexpr size_t DEFAULT_MAX_FRAME_SIZE = 64 * 1024 * 1024;
+constexpr char COMPRESSION_MARKER = static_cast<char>(0xFF);
+// Marker byte and algorithm.
+constexpr size_t ESCAPED_HEADER_SIZE = 2;
+// Marker byte, algorithm and original size.
+constexpr size_t COMPRESSED_HEADER_SIZE = 6;
+// Largest input accepted by LZ4. Larger frames are sent uncompressed.
+constexpr size_t MAX_COMPRESSED_FRAME_SIZE = 0x7E000000;
+// Largest ratio of the original size to the compressed size the formats can produce.
+// A match of LZ4 adds at most 255 bytes per byte of input. A zstd RLE block of 4 bytes
+// restores at most 128 KiB.
+constexpr size_t LZ4_MAX_RATIO = 255;
+constexpr size_t ZSTD_MAX_RATIO = 32768;
+
+/**
+ * @brief   Construct a new QZmqCompressor::QZmqCompressor object.
+ *
+ * @param algorithm Compression algorithm of the sent frames.
+ * @param level     Compression level. @sa QZmqCompressor::create()
+ */
+QZmqCompressor::QZmqCompressor(Algorithm algorithm, int level)
+{
+    this->method = algorithm;
+    this->compressionLevel = level;
+    this->minSize = DEFAULT_COMPRESSION_THRESHOLD;
+    this->maxSize = 0;
+    this->zstdCompressContext = NULL;
+    this->zstdDecompressContext = NULL;
+    this->zstdCompressDictionary = NULL;
+    this->zstdDecompressDictionary = NULL;
+}
+
+/**
+ * @brief   Destroy the QZmqCompressor::QZmqCompressor object.
+ */
+QZmqCompressor::~QZmqCompressor()
+{
+    clearDictionary();
+#ifdef QZMQ_WITH_ZSTD
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(this->zstdCompressContext));
+    ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(this->zstdDecompressContext));
+#endif
+    this->zstdCompressContext = NULL;
+    this->zstdDecompressContext = NULL;
+}
+
+/**
+ * @brief   Create a compressor. A compressor decompresses frames of every algorithm the
+ *          library is built with, whatever algorithm it uses for sending.
+ *          @sa QZmqSocket::setCompressor()
+ *
+ * @param algorithm Compression algorithm of the sent frames. With QZmqCompressor::None,
+ *                  frames are only decompressed, e.g. for a peer that sends compressed frames.
+ * @param level     Compression level. For zstd, the level as given to ZSTD_compressCCtx(),
+ *                  0 is the default of zstd. For LZ4, the acceleration of LZ4_compress_fast(),
+ *                  higher is faster with less compression.
+ * @return QZmqCompressor*  A pointer to the compressor or NULL with EPROTONOSUPPORT if the
+ *                          library is built without the algorithm.
+ */
+QZmqCompressor* QZmqCompressor::create(Algorithm algorithm, int level)
+{
+    if (!isSupported(algorithm)) {
+        errno = EPROTONOSUPPORT;
+        return NULL;
+    }
+    return new QZmqCompressor(algorithm, level);
+}
+
+/**
+ * @brief   Check if the library is built with the given algorithm.
+ *          Refer to the WITH_LZ4 and WITH_ZSTD build options.
+ *
+ * @param algorithm The compression algorithm.
+ * @return true     If the algorithm can be used.
+ * @return false    Otherwise.
+ */
+bool QZmqCompressor::isSupported(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case None:
+        return true;
+#ifdef QZMQ_WITH_LZ4
+    case LZ4:
+        return true;
+#endif
+#ifdef QZMQ_WITH_ZSTD
+    case Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief   Returns the algorithm used for the sent frames.
+ *
+ * @return Algorithm    The compression algorithm.
+ */
+QZmqCompressor::Algorithm QZmqCompressor::algorithm()
+{
+    return this->method;
+}
+
+/**
+ * @brief   Returns the compression level.
+ *
+ * @return int  The compression level.
+ */
+int QZmqCompressor::level()
+{
+    return this->compressionLevel;
+}
+
+/**
+ * @brief   Returns the size of the smallest frame that is compressed.
+ *
+ * @return size_t   Size in bytes.
+ */
+size_t QZmqCompressor::threshold()
+{
+    return this->minSize;
+}
+
+/**
+ * @brief   Set the size of the smallest frame that is compressed. Smaller frames rarely
+ *          shrink enough to pay for the time spent. 512 bytes by default.
+ *
+ * @param size  Size in bytes.
+ */
+void QZmqCompressor::setThreshold(size_t size)
+{
+    this->minSize = size;
+}
+
+/**
+ * @brief   Returns the largest original size of a received frame that is decompressed.
+ *          @sa QZmqCompressor::setMaxFrameSize()
+ *
+ * @return size_t   Size in bytes.
+ */
+size_t QZmqCompressor::maxFrameSize()
+{
+    return this->maxSize > 0 ? this->maxSize : DEFAULT_MAX_FRAME_SIZE;
+}
+
+/**
+ * @brief   Set the largest original size of a received frame that is decompressed.
+ *          The original size is given by the peer. Larger frames are dropped with EMSGSIZE
+ *          before any memory is allocated. Unless set, ZMQ_MAXMSGSIZE of the socket is used
+ *          if it is set when the compressor is given to QZmqSocket::setCompressor(), and
+ *          64 MiB otherwise.
+ *
+ * @param size  Size in bytes.
+ */
+void QZmqCompressor::setMaxFrameSize(size_t size)
+{
+    this->maxSize = qMin(size, MAX_COMPRESSED_FRAME_SIZE);
+}
+
+/**
+ * @brief   Set the dictionary of zstd, e.g. one trained with `zstd --train` on samples of
+ *          the messages. Dictionaries help small frames most. Both peers must use the same
+ *          dictionary. Received zstd frames are decompressed with the dictionary whatever
+ *          algorithm the compressor uses for sending.
+ *
+ * @param dictionary    Content of the dictionary. An empty dictionary removes the current one.
+ * @return true         If the operation is successful.
+ * @return false        With EPROTONOSUPPORT if the library is built without zstd, or with
+ *                      EINVAL if the dictionary cannot be loaded.
+ */
+bool QZmqCompressor::setDictionary(const QByteArray &dictionary)
+{
+    clearDictionary();
+    if (dictionary.isEmpty()) {
+        return true;
+    }
+
+#ifdef QZMQ_WITH_ZSTD
+    if (this->method == Zstd) {
+        this->zstdCompressDictionary = ZSTD_createCDict(dictionary.constData(), dictionary.size(),
+                                                        this->compressionLevel);
+        if (this->zstdCompressDictionary == NULL) {
+            errno = EINVAL;
+            return false;
+        }
+    }
+    this->zstdDecompressDictionary = ZSTD_createDDict(dictionary.constData(), dictionary.size());
+    if (this->zstdDecompressDictionary == NULL) {
+        clearDictionary();
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+#else
+    errno = EPROTONOSUPPORT;
+    return false;
+#endif
+}
+
+/**
+ * @brief   Free the dictionaries of zstd.
+ */
+void QZmqCompressor::clearDictionary()
+{
+#ifdef QZMQ_WITH_ZSTD
+    ZSTD_freeCDict(static_cast<ZSTD_CDict*>(this->zstdCompressDictionary));
+    ZSTD_freeDDict(static_cast<ZSTD_DDict*>(this->zstdDecompressDictionary));
+#endif
+    this->zstdCompressDictionary = NULL;
+    this->zstdDecompressDictionary = NULL;
+}
+
+/**
+ * @brief   Build the frame to be sent for the given frame.
+ *
+ * @param msg   The frame to be sent. It is left untouched, unless it is sent as it is.
+ *              Then, its content is moved to out without copying and msg becomes empty.
+ * @param out   An uninitialized message that receives the frame for the wire.
+ *              It is initialized only if the operation is successful.
+ * @return true     If the operation is successful.
+ * @return false    If the message cannot be allocated.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqCompressor::compress(zmq_msg_t *msg, zmq_msg_t *out)
+{
+    const char *data = static_cast<const char*>(zmq_msg_data(msg));
+    size_t size = zmq_msg_size(msg);
+    if (this->method == None || size < this->minSize || size > MAX_COMPRESSED_FRAME_SIZE) {
+        return passThrough(msg, out);
+    }
+
+    // The size of a message cannot be changed after allocation. So, the content is
+    // compressed into a buffer first and only the compressed bytes are copied.
+    int capacity = compressBound(size);
+    if (this->buffer.size() < capacity) {
+        this->buffer.resize(capacity);
+    }
+    int compressedSize = compressData(data, size, this->buffer.data(), capacity);
+    if (compressedSize <= 0 || COMPRESSED_HEADER_SIZE + compressedSize >= size) {
+        // Incompressible content. Errors of the library end up here as well.
+        return passThrough(msg, out);
+    }
+
+    if (zmq_msg_init_size(out, COMPRESSED_HEADER_SIZE + compressedSize) != 0) {
+        return false;
+    }
+    char *dst = static_cast<char*>(zmq_msg_data(out));
+    dst[0] = COMPRESSION_MARKER;
+    dst[1] = static_cast<char>(this->method);
+    qToLittleEndian<quint32>(static_cast<quint32>(size), dst + ESCAPED_HEADER_SIZE);
+    memcpy(dst + COMPRESSED_HEADER_SIZE, this->buffer.constData(), compressedSize);
+    return true;
+}
+
+/**
+ * @brief   Restore the content of a received frame.
+ *
+ * @param msg   The received frame. It is left untouched, unless it was sent as it is.
+ *              Then, its content is moved to out without copying and msg becomes empty.
+ * @param out   An uninitialized message that receives the content.
+ *              It is initialized only if the operation is successful.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The error code is EPROTO for
+ *                  malformed frames, EMSGSIZE for frames larger than
+ *                  QZmqCompressor::maxFrameSize() and EPROTONOSUPPORT for algorithms the
+ *                  library is built without. Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqCompressor::decompress(zmq_msg_t *msg, zmq_msg_t *out)
+{
+    const char *data = static_cast<const char*>(zmq_msg_data(msg));
+    size_t size = zmq_msg_size(msg);
+    if (size == 0 || data[0] != COMPRESSION_MARKER) {
+        return zmq_msg_init(out) == 0 && zmq_msg_move(out, msg) == 0;
+    }
+    if (size < ESCAPED_HEADER_SIZE) {
+        errno = EPROTO;
+        return false;
+    }
+
+    char algorithm = data[1];
+    if (algorithm == None) {
+        if (zmq_msg_init_size(out, size - ESCAPED_HEADER_SIZE) != 0) {
+            return false;
+        }
+        memcpy(zmq_msg_data(out), data + ESCAPED_HEADER_SIZE, size - ESCAPED_HEADER_SIZE);
+        return true;
+    }
+    // The algorithm comes from the peer as well. Reject it before anything is allocated.
+    if (algorithm != LZ4 && algorithm != Zstd) {
+        errno = EPROTO;
+        return false;
+    }
+    if (!isSupported(static_cast<Algorithm>(algorithm))) {
+        errno = EPROTONOSUPPORT;
+        return false;
+    }
+
+    if (size < COMPRESSED_HEADER_SIZE) {
+        errno = EPROTO;
+        return false;
+    }
+    // The original size comes from the peer. Check it before allocating.
+    size_t originalSize = qFromLittleEndian<quint32>(data + ESCAPED_HEADER_SIZE);
+    if (originalSize > maxFrameSize()) {
+        errno = EMSGSIZE;
+        return false;
+    }
+    size_t maxRatio = algorithm == LZ4 ? LZ4_MAX_RATIO : ZSTD_MAX_RATIO;
+    if (originalSize / maxRatio > size - COMPRESSED_HEADER_SIZE) {
+        errno = EPROTO;
+        return false;
+    }
+
+    if (zmq_msg_init_size(out, originalSize) != 0) {
+        return false;
+    }
+    if (!decompressData(algorithm, data + COMPRESSED_HEADER_SIZE, size - COMPRESSED_HEADER_SIZE,
+                        static_cast<char*>(zmq_msg_data(out)), originalSize)) {
+        int error = QZmqError::getLastError();
+        zmq_msg_close(out);
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Check if a frame on the wire is compressed.
+ *
+ * @param msg   The frame as it is sent or received.
+ * @return true     If the frame holds compressed content.
+ * @return false    If the frame holds the content as it is, escaped or not.
+ */
+bool QZmqCompressor::isCompressed(zmq_msg_t *msg)
+{
+    const char *data = static_cast<const char*>(zmq_msg_data(msg));
+    return zmq_msg_size(msg) >= COMPRESSED_HEADER_SIZE && data[0] == COMPRESSION_MARKER && data[1] != None;
+}
+
+/**
+ * @brief   Build the frame for the wire of content that is not compressed.
+ *          The content is moved without copying, unless it starts with the marker byte.
+ *          Then, it is copied into an escaped frame.
+ */
+bool QZmqCompressor::passThrough(zmq_msg_t *msg, zmq_msg_t *out)
+{
+    const char *data = static_cast<const char*>(zmq_msg_data(msg));
+    size_t size = zmq_msg_size(msg);
+    if (size == 0 || data[0] != COMPRESSION_MARKER) {
+        return zmq_msg_init(out) == 0 && zmq_msg_move(out, msg) == 0;
+    }
+    if (zmq_msg_init_size(out, size + ESCAPED_HEADER_SIZE) != 0) {
+        return false;
+    }
+    char *dst = static_cast<char*>(zmq_msg_data(out));
+    dst[0] = COMPRESSION_MARKER;
+    dst[1] = None;
+    memcpy(dst + ESCAPED_HEADER_SIZE, data, size);
+    return true;
+}
+
+/**
+ * @brief   Returns the largest compressed size of the given number of bytes.
+ */
+int QZmqCompressor::compressBound(size_t size)
+{
+    switch (this->method) {
+#ifdef QZMQ_WITH_LZ4
+    case LZ4:
+        return LZ4_compressBound(static_cast<int>(size));
+#endif
+#ifdef QZMQ_WITH_ZSTD
+    case Zstd:
+        return static_cast<int>(ZSTD_compressBound(size));
+#endif
+    default:
+        return static_cast<int>(size);
+    }
+}
+
+/**
+ * @brief   Compress with the algorithm of the compressor.
+ *
+ * @return int  Compressed size or a negative value if the content cannot be compressed.
+ */
+int QZmqCompressor::compressData(const char *data, size_t size, char *dst, int capacity)
+{
+    switch (this->method) {
+#ifdef QZMQ_WITH_LZ4
+    case LZ4:
+        return LZ4_compress_fast(data, dst, static_cast<int>(size), capacity,
+                                 qMax(1, this->compressionLevel));
+#endif
+#ifdef QZMQ_WITH_ZSTD
+    case Zstd: {
+        if (this->zstdCompressContext == NULL) {
+            this->zstdCompressContext = ZSTD_createCCtx();
+            if (this->zstdCompressContext == NULL) {
+                return -1;
+            }
+        }
+        ZSTD_CCtx *context = static_cast<ZSTD_CCtx*>(this->zstdCompressContext);
+        size_t rc;
+        if (this->zstdCompressDictionary != NULL) {
+            rc = ZSTD_compress_usingCDict(context, dst, capacity, data, size,
+                                          static_cast<ZSTD_CDict*>(this->zstdCompressDictionary));
+        } else {
+            rc = ZSTD_compressCCtx(context, dst, capacity, data, size, this->compressionLevel);
+        }
+        return ZSTD_isError(rc) ? -1 : static_cast<int>(rc);
+    }
+#endif
+    default:
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+        Q_UNUSED(dst);
+        Q_UNUSED(capacity);
+        return -1;
+    }
+}
+
+/**
+ * @brief   Decompress with the algorithm given by the flag byte of a frame.
+ *          The content must restore exactly the original size.
+ */
+bool QZmqCompressor::decompressData(char flag, const char *data, size_t size, char *dst, size_t originalSize)
+{
+    switch (flag) {
+    case LZ4:
+#ifdef QZMQ_WITH_LZ4
+        if (LZ4_decompress_safe(data, dst, static_cast<int>(size), static_cast<int>(originalSize))
+                != static_cast<int>(originalSize)) {
+            errno = EPROTO;
+            return false;
+        }
+        return true;
+#else
+        errno = EPROTONOSUPPORT;
+        return false;
+#endif
+    case Zstd: {
+#ifdef QZMQ_WITH_ZSTD
+        if (this->zstdDecompressContext == NULL) {
+            this->zstdDecompressContext = ZSTD_createDCtx();
+            if (this->zstdDecompressContext == NULL) {
+                errno = ENOMEM;
+                return false;
+            }
+        }
+        ZSTD_DCtx *context = static_cast<ZSTD_DCtx*>(this->zstdDecompressContext);
+        size_t rc;
+        if (this->zstdDecompressDictionary != NULL) {
+            rc = ZSTD_decompress_usingDDict(context, dst, originalSize, data, size,
+                                            static_cast<ZSTD_DDict*>(this->zstdDecompressDictionary));
+        } else {
+            rc = ZSTD_decompressDCtx(context, dst, originalSize, data, size);
+        }
+        if (ZSTD_isError(rc) || rc != originalSize) {
+            errno = EPROTO;
+            return false;
+        }
+        return true;
+#else
+        errno = EPROTONOSUPPORT;
+        return false;
+#endif
+    }
+    default:
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+        Q_UNUSED(dst);
+        Q_UNUSED(originalSize);
+        errno = EPROTO;
+        return false;
+    }
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,79 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_COMPRESSOR_H__
+#define __QZMQ_COMPRESSOR_H__
+
+#include "qzmqcommon.hpp"
+#include <zmq.h>
+#include <QByteArray>
+
+QZMQ_BEGIN_NAMESPACE
+
+// Compresses the frames sent by a socket and decompresses the frames it receives.
+// Compressed frames start with a marker byte (0xFF), the algorithm and the original size
+// (32-bit little endian), followed by the compressed content. Frames smaller than the
+// threshold and frames that do not shrink are sent as they are, without copying. Only such
+// frames that start with the marker byte themselves are escaped with the marker byte and
+// QZmqCompressor::None.
+// A compressor keeps compression contexts and buffers. It must not be shared by sockets.
+class QZMQ_API QZmqCompressor
+{
+public:
+    enum Algorithm
+    {
+        None = 0,
+        LZ4 = 1,
+        Zstd = 2
+    };
+
+    static QZmqCompressor* create(Algorithm algorithm, int level=0);
+    static bool isSupported(Algorithm algorithm);
+    virtual ~QZmqCompressor();
+    Algorithm algorithm();
+    int level();
+    size_t threshold();
+    void setThreshold(size_t size);
+    size_t maxFrameSize();
+    void setMaxFrameSize(size_t size);
+    bool setDictionary(const QByteArray &dictionary);
+    bool compress(zmq_msg_t *msg, zmq_msg_t *out);
+    bool decompress(zmq_msg_t *msg, zmq_msg_t *out);
+    static bool isCompressed(zmq_msg_t *msg);
+
+protected:
+    friend class QZmqSocket;
+    QZmqCompressor(Algorithm algorithm, int level);
+    Q_DISABLE_COPY(QZmqCompressor);
+    bool passThrough(zmq_msg_t *msg, zmq_msg_t *out);
+    int compressBound(size_t size);
+    int compressData(const char *data, size_t size, char *dst, int capacity);
+    bool decompressData(char flag, const char *data, size_t size, char *dst, size_t originalSize);
+    void clearDictionary();
+
+    Algorithm method;
+    int compressionLevel;
+    size_t minSize;
+    size_t maxSize;         // 0 until set, @sa QZmqCompressor::maxFrameSize()
+    QByteArray buffer;
+    // Library specific contexts. They are created on first use.
+    void *zstdCompressContext;
+    void *zstdDecompressContext;
+    void *zstdCompressDictionary;
+    void *zstdDecompressDictionary;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_COMPRESSOR_H__
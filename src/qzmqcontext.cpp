@@ -14,15 +14,34 @@
 
 #include "qzmqcontext.hpp"
 #include <zmq.h>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
 
 QZMQ_BEGIN_NAMESPACE
 
-QZmqContext::QZmqContext() : QObject(nullptr)
+// Options applied to every context when it is created.
+static QMutex defaultOptionsMutex;
+static QVector<QPair<int, int> >& defaultOptions()
+{
+    static QVector<QPair<int, int> > options;
+    return options;
+}
+
+QZmqContext::QZmqContext(QObject *parent) : QObject(parent)
 {
     this->context = zmq_ctx_new();
     Q_ASSERT(this->context != NULL);
+
+    // Options such as the number of I/O threads take effect only if they are set
+    // before the first socket is created.
+    QMutexLocker locker(&defaultOptionsMutex);
+    for (const QPair<int, int> &option : defaultOptions()) {
+        zmq_ctx_set(this->context, option.first, option.second);
+    }
 }
 
+// All sockets of the context must be closed before the context is destroyed.
 QZmqContext::~QZmqContext()
 {
     if (this->context != NULL) {
@@ -32,6 +51,13 @@ QZmqContext::~QZmqContext()
     }
 }
 
+// Create a context in addition to the shared instance, e.g. one per NUMA node.
+// Configure it before creating any sockets with QZmqSocket::create(QZmqContext*, int, QObject*).
+QZmqContext* QZmqContext::create(QObject *parent)
+{
+    return new QZmqContext(parent);
+}
+
 bool QZmqContext::setOption(int option, int value)
 {
     Q_ASSERT(this->context != NULL);
@@ -46,6 +72,47 @@ bool QZmqContext::getOption(int option, int &value)
     return value >= 0;
 }
 
+bool QZmqContext::setIoThreads(int count)
+{
+    return setOption(ZMQ_IO_THREADS, count);
+}
+
+int QZmqContext::ioThreads()
+{
+    int value = 0;
+    getOption(ZMQ_IO_THREADS, value);
+    return value;
+}
+
+bool QZmqContext::setMaxSockets(int count)
+{
+    return setOption(ZMQ_MAX_SOCKETS, count);
+}
+
+int QZmqContext::maxSockets()
+{
+    int value = 0;
+    getOption(ZMQ_MAX_SOCKETS, value);
+    return value;
+}
+
+// Pin the I/O threads to the given CPU in addition to the CPUs added before.
+bool QZmqContext::addThreadAffinityCpu(int cpu)
+{
+    return setOption(ZMQ_THREAD_AFFINITY_CPU_ADD, cpu);
+}
+
+// Scheduling policy of the I/O threads, e.g. SCHED_FIFO.
+bool QZmqContext::setThreadSchedulingPolicy(int policy)
+{
+    return setOption(ZMQ_THREAD_SCHED_POLICY, policy);
+}
+
+bool QZmqContext::setThreadPriority(int priority)
+{
+    return setOption(ZMQ_THREAD_PRIORITY, priority);
+}
+
 void* QZmqContext::zmqContext()
 {
     return this->context;
@@ -62,4 +129,20 @@ QZmqContext* QZmqContext::instance()
     return &instance;
 }
 
+// Set an option for the contexts created from now on, including the shared instance
+// if it is not created yet. This is the way to configure the shared instance before
+// it is used for the first time.
+void QZmqContext::setDefaultOption(int option, int value)
+{
+    QMutexLocker locker(&defaultOptionsMutex);
+    QVector<QPair<int, int> > &options = defaultOptions();
+    for (QPair<int, int> &existing : options) {
+        if (existing.first == option && option != ZMQ_THREAD_AFFINITY_CPU_ADD) {
+            existing.second = value;
+            return;
+        }
+    }
+    options.append(qMakePair(option, value));
+}
+
 QZMQ_END_NAMESPACE
\ No newline at end of file
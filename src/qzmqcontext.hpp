@@ -24,19 +24,28 @@ class QObject;
 class QZMQ_API QZmqContext : public QObject
 {
 public:
+    static QZmqContext* create(QObject *parent=nullptr);
+    virtual ~QZmqContext();
     bool setOption(int option, int value);
     bool getOption(int option, int &value);
+    bool setIoThreads(int count);
+    int ioThreads();
+    bool setMaxSockets(int count);
+    int maxSockets();
+    bool addThreadAffinityCpu(int cpu);
+    bool setThreadSchedulingPolicy(int policy);
+    bool setThreadPriority(int priority);
     void* zmqContext();
     static QZmqContext* instance();
+    static void setDefaultOption(int option, int value);
 
 protected:
     friend class QZmqSocket;
-    QZmqContext();
-    virtual ~QZmqContext();
+    QZmqContext(QObject *parent=nullptr);
     Q_DISABLE_COPY(QZmqContext);
     void *context; 
 };
 
 QZMQ_END_NAMESPACE
 
-#endif // __QZMQ_CONTEXT_H__
\ No newline at end of file
+#endif // __QZMQ_CONTEXT_H__
@@ -0,0 +1,534 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqeventdispatcher.hpp"
+#include "qzmqreactor.hpp"
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QEvent>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr int MAX_EPOLL_EVENTS = 256;
+
+/**
+ * @brief   Construct a new QZmqEventDispatcher::QZmqEventDispatcher object.
+ *          Install the dispatcher with QCoreApplication::setEventDispatcher() or
+ *          QThread::setEventDispatcher() before the event loop of the thread starts.
+ *
+ * @param parent Parent object of the dispatcher.
+ */
+QZmqEventDispatcher::QZmqEventDispatcher(QObject *parent) : QAbstractEventDispatcher(parent)
+{
+    this->reactor = NULL;
+    this->epollEvents = new struct epoll_event[MAX_EPOLL_EVENTS];
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    Q_ASSERT(this->epollFd >= 0);
+
+    this->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Q_ASSERT(this->eventFd >= 0);
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = this->eventFd;
+    int rc = epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->eventFd, &event);
+    Q_ASSERT(rc == 0);
+    Q_UNUSED(rc);
+}
+
+/**
+ * @brief   Destroy the QZmqEventDispatcher::QZmqEventDispatcher object.
+ */
+QZmqEventDispatcher::~QZmqEventDispatcher()
+{
+    if (this->reactor != NULL) {
+        this->reactor->dispatcher = NULL;
+        this->reactor = NULL;
+    }
+
+    if (this->eventFd >= 0) {
+        close(this->eventFd);
+        this->eventFd = -1;
+    }
+
+    if (this->epollFd >= 0) {
+        close(this->epollFd);
+        this->epollFd = -1;
+    }
+
+    delete[] this->epollEvents;
+    this->epollEvents = NULL;
+}
+
+/**
+ * @brief   Attach the ØMQ reactor of this thread.
+ *          The dispatcher asks the reactor for pending ØMQ events before blocking.
+ *
+ * @param reactor   A pointer to the reactor. NULL detaches the current reactor.
+ */
+void QZmqEventDispatcher::setReactor(QZmqReactor *reactor)
+{
+    this->reactor = reactor;
+}
+
+/**
+ * @brief   Returns a monotonic timestamp in milliseconds.
+ *
+ * @return qint64   Milliseconds since an unspecified point in time.
+ */
+qint64 QZmqEventDispatcher::monotonicTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (qint64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief   Process pending events.
+ *          ØMQ sockets registered with the reactor of this thread are checked before
+ *          blocking in epoll_wait(). If any socket has pending events, the dispatcher
+ *          does not block, so no wake-up timers are needed to work around edge triggered
+ *          notifications of ØMQ.
+ *
+ * @param flags     Refer to the documentation of QAbstractEventDispatcher::processEvents().
+ * @return true     If an event was processed.
+ * @return false    If no events were processed.
+ */
+bool QZmqEventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags)
+{
+    this->interrupted.storeRelaxed(0);
+    // Every posted event calls wakeUp(). Events posted from now on are either sent
+    // below or keep the dispatcher from blocking.
+    this->wakeUps.storeRelaxed(0);
+
+    // We are awake, broadcast it
+    emit awake();
+    QCoreApplication::sendPostedEvents();
+
+    const bool includeTimers = (flags & QEventLoop::X11ExcludeTimers) == 0;
+    const bool includeNotifiers = (flags & QEventLoop::ExcludeSocketNotifiers) == 0;
+    const bool waitForEvents = (flags & QEventLoop::WaitForMoreEvents) != 0;
+    bool canWait = waitForEvents && this->interrupted.loadRelaxed() == 0 && this->wakeUps.loadRelaxed() == 0;
+
+    if (canWait) {
+        emit aboutToBlock();
+    }
+
+    if (this->interrupted.loadRelaxed() != 0) {
+        return false;
+    }
+
+    int timeout = 0;
+    if (canWait) {
+        timeout = includeTimers ? timersTimeout(monotonicTime()) : -1;
+        if (timeout != 0 && this->reactor != NULL && this->reactor->hasPendingEvents()) {
+            // ØMQ sockets have events that do not show up in their file descriptors.
+            timeout = 0;
+        }
+    }
+
+    int count = epoll_wait(this->epollFd, this->epollEvents, MAX_EPOLL_EVENTS, timeout);
+    if (count < 0) {
+        Q_ASSERT(errno == EINTR);
+        count = 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (this->epollEvents[i].data.fd == this->eventFd) {
+            eventfd_t value;
+            eventfd_read(this->eventFd, &value);
+        }
+    }
+
+    int nevents = 0;
+    if (includeNotifiers) {
+        nevents += activateSocketNotifiers(count);
+        if (this->reactor != NULL) {
+            // ØMQ sockets are dispatched directly instead of on the next awake() signal.
+            this->reactor->processEvents();
+        }
+    }
+    if (includeTimers) {
+        nevents += activateTimers();
+    }
+
+    return nevents > 0;
+}
+
+/**
+ * @brief   See if there are posted events waiting to be processed.
+ *          Events are posted through QZmqEventDispatcher::wakeUp(), so the result may be
+ *          true for events that are already sent.
+ *
+ * @return true     If there are pending events.
+ * @return false    If there are no pending events.
+ */
+bool QZmqEventDispatcher::hasPendingEvents()
+{
+    return this->wakeUps.loadRelaxed() != 0;
+}
+
+/**
+ * @brief   Update the epoll registration of a file descriptor.
+ *
+ * @param fd        File descriptor.
+ * @param notifiers Socket notifiers associated with the file descriptor.
+ * @param op        One of EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ */
+bool QZmqEventDispatcher::updateSocketNotifiers(int fd, const SocketNotifiers &notifiers, int op)
+{
+    struct epoll_event event;
+    event.events = 0;
+    event.data.fd = fd;
+    if (notifiers.read != NULL) {
+        event.events |= EPOLLIN;
+    }
+    if (notifiers.write != NULL) {
+        event.events |= EPOLLOUT;
+    }
+    if (notifiers.exception != NULL) {
+        event.events |= EPOLLPRI;
+    }
+
+    int rc = epoll_ctl(this->epollFd, op, fd, &event);
+    return rc == 0;
+}
+
+/**
+ * @brief   Register a socket notifier.
+ *
+ * @param notifier  A pointer to the socket notifier.
+ */
+void QZmqEventDispatcher::registerSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier != NULL);
+    int fd = notifier->socket();
+
+    auto it = this->socketNotifiers.find(fd);
+    bool exists = it != this->socketNotifiers.end();
+    if (!exists) {
+        SocketNotifiers notifiers = { NULL, NULL, NULL };
+        it = this->socketNotifiers.insert(fd, notifiers);
+    }
+
+    switch (notifier->type()) {
+    case QSocketNotifier::Read:
+        it->read = notifier;
+        break;
+    case QSocketNotifier::Write:
+        it->write = notifier;
+        break;
+    case QSocketNotifier::Exception:
+        it->exception = notifier;
+        break;
+    }
+
+    if (!updateSocketNotifiers(fd, *it, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD)) {
+        qWarning("QZmqEventDispatcher: Cannot register socket notifier for fd %d", fd);
+    }
+}
+
+/**
+ * @brief   Unregister a socket notifier.
+ *
+ * @param notifier  A pointer to the socket notifier.
+ */
+void QZmqEventDispatcher::unregisterSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier != NULL);
+    int fd = notifier->socket();
+
+    auto it = this->socketNotifiers.find(fd);
+    if (it == this->socketNotifiers.end()) {
+        return;
+    }
+
+    if (it->read == notifier) {
+        it->read = NULL;
+    } else if (it->write == notifier) {
+        it->write = NULL;
+    } else if (it->exception == notifier) {
+        it->exception = NULL;
+    }
+
+    if (it->read == NULL && it->write == NULL && it->exception == NULL) {
+        // The file descriptor may already be closed. So, errors are ignored.
+        updateSocketNotifiers(fd, *it, EPOLL_CTL_DEL);
+        this->socketNotifiers.erase(it);
+    } else {
+        updateSocketNotifiers(fd, *it, EPOLL_CTL_MOD);
+    }
+}
+
+/**
+ * @brief   Activate the socket notifiers of the file descriptors reported by epoll_wait().
+ *
+ * @param count     Number of events reported by epoll_wait().
+ * @return int      Number of activated socket notifiers.
+ */
+int QZmqEventDispatcher::activateSocketNotifiers(int count)
+{
+    // Notifier handlers may spin a nested event loop that activates notifiers itself.
+    // So, the pending notifiers are kept on the stack.
+    QVector<PendingNotifier> pending;
+    for (int i = 0; i < count; i++) {
+        const struct epoll_event &event = this->epollEvents[i];
+        auto it = this->socketNotifiers.constFind(event.data.fd);
+        if (it == this->socketNotifiers.constEnd()) {
+            continue;
+        }
+
+        if (it->read != NULL && (event.events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+            pending.append({ event.data.fd, QSocketNotifier::Read });
+        }
+        if (it->write != NULL && (event.events & (EPOLLOUT | EPOLLHUP | EPOLLERR))) {
+            pending.append({ event.data.fd, QSocketNotifier::Write });
+        }
+        if (it->exception != NULL && (event.events & EPOLLPRI)) {
+            pending.append({ event.data.fd, QSocketNotifier::Exception });
+        }
+    }
+
+    int activated = 0;
+    QEvent event(QEvent::SockAct);
+    for (const PendingNotifier &entry : pending) {
+        // Notifiers may be unregistered by the handlers of other notifiers.
+        auto it = this->socketNotifiers.constFind(entry.fd);
+        if (it == this->socketNotifiers.constEnd()) {
+            continue;
+        }
+        QSocketNotifier *notifier = NULL;
+        switch (entry.type) {
+        case QSocketNotifier::Read:
+            notifier = it->read;
+            break;
+        case QSocketNotifier::Write:
+            notifier = it->write;
+            break;
+        case QSocketNotifier::Exception:
+            notifier = it->exception;
+            break;
+        }
+        if (notifier != NULL) {
+            QCoreApplication::sendEvent(notifier, &event);
+            activated++;
+        }
+    }
+
+    return activated;
+}
+
+/**
+ * @brief   Register a timer.
+ *
+ * @param timerId   Refer to the documentation of QAbstractEventDispatcher::registerTimer().
+ * @param interval  Refer to the documentation of QAbstractEventDispatcher::registerTimer().
+ * @param timerType Refer to the documentation of QAbstractEventDispatcher::registerTimer().
+ * @param object    Refer to the documentation of QAbstractEventDispatcher::registerTimer().
+ */
+void QZmqEventDispatcher::registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object)
+{
+    Timer timer;
+    timer.id = timerId;
+    timer.interval = interval;
+    timer.type = timerType;
+    timer.object = object;
+    timer.timeout = monotonicTime() + interval;
+    timer.active = false;
+    this->timers.append(timer);
+}
+
+/**
+ * @brief   Unregister a timer.
+ *
+ * @param timerId   Id of the timer.
+ * @return true     If the timer was registered.
+ * @return false    If the timer was not registered.
+ */
+bool QZmqEventDispatcher::unregisterTimer(int timerId)
+{
+    for (int i = 0; i < this->timers.size(); i++) {
+        if (this->timers[i].id == timerId) {
+            this->timers.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief   Unregister all timers of an object.
+ *
+ * @param object    A pointer to the object.
+ * @return true     If at least one timer was unregistered.
+ * @return false    If the object did not have timers.
+ */
+bool QZmqEventDispatcher::unregisterTimers(QObject *object)
+{
+    bool found = false;
+    for (int i = this->timers.size() - 1; i >= 0; i--) {
+        if (this->timers[i].object == object) {
+            this->timers.remove(i);
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief   Returns the timers registered for an object.
+ *
+ * @param object    A pointer to the object.
+ * @return QList<TimerInfo>     Registered timers.
+ */
+QList<QAbstractEventDispatcher::TimerInfo> QZmqEventDispatcher::registeredTimers(QObject *object) const
+{
+    QList<TimerInfo> list;
+    for (const Timer &timer : this->timers) {
+        if (timer.object == object) {
+            list.append(TimerInfo(timer.id, timer.interval, timer.type));
+        }
+    }
+    return list;
+}
+
+/**
+ * @brief   Returns the remaining time of a timer in milliseconds.
+ *
+ * @param timerId   Id of the timer.
+ * @return int      Remaining time in milliseconds or -1 if the timer is not registered.
+ */
+int QZmqEventDispatcher::remainingTime(int timerId)
+{
+    qint64 now = monotonicTime();
+    for (const Timer &timer : this->timers) {
+        if (timer.id == timerId) {
+            return timer.timeout > now ? (int)(timer.timeout - now) : 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief   Compute the time until the next timer expires.
+ *
+ * @param now       Current monotonic time in milliseconds.
+ * @return int      Timeout in milliseconds or -1 if there are no timers.
+ */
+int QZmqEventDispatcher::timersTimeout(qint64 now)
+{
+    qint64 timeout = -1;
+    for (const Timer &timer : this->timers) {
+        if (timer.active) {
+            continue;
+        }
+        qint64 remaining = timer.timeout > now ? timer.timeout - now : 0;
+        if (timeout < 0 || remaining < timeout) {
+            timeout = remaining;
+        }
+    }
+    return (int)timeout;
+}
+
+/**
+ * @brief   Send timer events to the objects of the expired timers.
+ *
+ * @return int  Number of activated timers.
+ */
+int QZmqEventDispatcher::activateTimers()
+{
+    qint64 now = monotonicTime();
+
+    // Timer handlers may spin a nested event loop that activates timers itself.
+    // So, the due timers are kept on the stack.
+    QVector<int> dueTimers;
+    for (Timer &timer : this->timers) {
+        if (!timer.active && timer.timeout <= now) {
+            dueTimers.append(timer.id);
+            timer.timeout += timer.interval;
+            if (timer.timeout <= now) {
+                timer.timeout = now + timer.interval;
+            }
+        }
+    }
+
+    int activated = 0;
+    for (int id : dueTimers) {
+        // Timers may be unregistered by the handlers of other timers.
+        int index = -1;
+        for (int i = 0; i < this->timers.size(); i++) {
+            if (this->timers[i].id == id) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) {
+            continue;
+        }
+
+        // Prevent the same timer from firing in a nested event loop.
+        this->timers[index].active = true;
+        QObject *object = this->timers[index].object;
+        QTimerEvent event(id);
+        QCoreApplication::sendEvent(object, &event);
+        activated++;
+
+        for (Timer &timer : this->timers) {
+            if (timer.id == id) {
+                timer.active = false;
+                break;
+            }
+        }
+    }
+
+    return activated;
+}
+
+/**
+ * @brief   Wake up the dispatcher if it is blocked. This function is thread safe.
+ */
+void QZmqEventDispatcher::wakeUp()
+{
+    // Only the first wake-up since the last activation touches the eventfd.
+    if (this->wakeUps.testAndSetAcquire(0, 1)) {
+        eventfd_write(this->eventFd, 1);
+    }
+}
+
+/**
+ * @brief   Interrupt event processing. This function is thread safe.
+ */
+void QZmqEventDispatcher::interrupt()
+{
+    this->interrupted.storeRelaxed(1);
+    wakeUp();
+}
+
+/**
+ * @brief   Nothing to be flushed.
+ */
+void QZmqEventDispatcher::flush()
+{
+    // Nothing to be done here.
+}
+
+QZMQ_END_NAMESPACE
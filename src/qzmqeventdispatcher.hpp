@@ -0,0 +1,100 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_EVENT_DISPATCHER_H__
+#define __QZMQ_EVENT_DISPATCHER_H__
+
+#include "qzmqcommon.hpp"
+#include <QAbstractEventDispatcher>
+#include <QAtomicInt>
+#include <QHash>
+#include <QSocketNotifier>
+#include <QVector>
+
+struct epoll_event;
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqReactor;
+class QZMQ_API QZmqEventDispatcher : public QAbstractEventDispatcher
+{
+    Q_OBJECT
+public:
+    explicit QZmqEventDispatcher(QObject *parent=nullptr);
+    virtual ~QZmqEventDispatcher();
+
+    bool processEvents(QEventLoop::ProcessEventsFlags flags) override;
+    bool hasPendingEvents() override;
+
+    void registerSocketNotifier(QSocketNotifier *notifier) override;
+    void unregisterSocketNotifier(QSocketNotifier *notifier) override;
+
+    using QAbstractEventDispatcher::registerTimer;
+    void registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object) override;
+    bool unregisterTimer(int timerId) override;
+    bool unregisterTimers(QObject *object) override;
+    QList<TimerInfo> registeredTimers(QObject *object) const override;
+    int remainingTime(int timerId) override;
+
+    void wakeUp() override;
+    void interrupt() override;
+    void flush() override;
+
+protected:
+    friend class QZmqReactor;
+    Q_DISABLE_COPY(QZmqEventDispatcher);
+
+    struct SocketNotifiers
+    {
+        QSocketNotifier *read;
+        QSocketNotifier *write;
+        QSocketNotifier *exception;
+    };
+
+    struct PendingNotifier
+    {
+        int fd;
+        QSocketNotifier::Type type;
+    };
+
+    struct Timer
+    {
+        int id;
+        int interval;
+        Qt::TimerType type;
+        QObject *object;
+        qint64 timeout;
+        bool active;
+    };
+
+    void setReactor(QZmqReactor *reactor);
+    bool updateSocketNotifiers(int fd, const SocketNotifiers &notifiers, int op);
+    int timersTimeout(qint64 now);
+    int activateSocketNotifiers(int count);
+    int activateTimers();
+    static qint64 monotonicTime();
+
+    int epollFd;
+    int eventFd;
+    QAtomicInt wakeUps;
+    QAtomicInt interrupted;
+    QZmqReactor *reactor;
+    QHash<int, SocketNotifiers> socketNotifiers;
+    QVector<Timer> timers;
+    struct epoll_event *epollEvents;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_EVENT_DISPATCHER_H__
@@ -0,0 +1,362 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqframe.hpp"
+#include <cstring>
+
+QZMQ_BEGIN_NAMESPACE
+
+// libzmq stores messages of up to 33 bytes (max_vsm_size of a 64-byte zmq_msg_t)
+// inside zmq_msg_t itself. Copying such small payloads is cheaper than sharing them.
+constexpr size_t ZERO_COPY_THRESHOLD = 33;
+
+static void releaseByteArray(void *data, void *hint)
+{
+    Q_UNUSED(data);
+    delete static_cast<QByteArray*>(hint);
+}
+
+static void releaseSharedByteArray(void *data, void *hint)
+{
+    Q_UNUSED(data);
+    delete static_cast<QSharedPointer<QByteArray>*>(hint);
+}
+
+/**
+ * @brief   Construct an empty frame.
+ */
+QZmqFrame::QZmqFrame()
+{
+    int rc = zmq_msg_init(&this->msg);
+    Q_ASSERT(rc == 0);
+    Q_UNUSED(rc);
+}
+
+/**
+ * @brief   Construct a frame of the given size.
+ *          The frame is empty if the initialization is failed.
+ * 
+ * @param size  Size of the frame in bytes.
+ */
+QZmqFrame::QZmqFrame(size_t size)
+{
+    if (zmq_msg_init_size(&this->msg, size) != 0) {
+        zmq_msg_init(&this->msg);
+    }
+}
+
+/**
+ * @brief   Construct a frame with a copy of the given data.
+ *          The frame is empty if the initialization is failed.
+ * 
+ * @param data  A pointer to the data to be copied.
+ * @param size  Size of the data in bytes.
+ */
+QZmqFrame::QZmqFrame(const void *data, size_t size)
+{
+    if (zmq_msg_init_size(&this->msg, size) != 0) {
+        zmq_msg_init(&this->msg);
+        return;
+    }
+    if (size > 0) {
+        memcpy(zmq_msg_data(&this->msg), data, size);
+    }
+}
+
+/**
+ * @brief   Construct a frame that shares the data of the given byte array.
+ *          The frame is empty if the initialization is failed.
+ *          @sa QZmqFrame::rebuild(const QByteArray &data)
+ * 
+ * @param data  The byte array.
+ */
+QZmqFrame::QZmqFrame(const QByteArray &data)
+{
+    zmq_msg_init(&this->msg);
+    rebuild(data);
+}
+
+/**
+ * @brief   Move constructor. The other frame becomes empty.
+ * 
+ * @param other The frame to be moved.
+ */
+QZmqFrame::QZmqFrame(QZmqFrame &&other) noexcept
+{
+    zmq_msg_init(&this->msg);
+    int rc = zmq_msg_move(&this->msg, &other.msg);
+    Q_ASSERT(rc == 0);
+    Q_UNUSED(rc);
+}
+
+/**
+ * @brief   Move assignment. The content of this frame is released and the other frame
+ *          becomes empty.
+ * 
+ * @param other The frame to be moved.
+ * @return QZmqFrame&   Reference to this frame.
+ */
+QZmqFrame& QZmqFrame::operator=(QZmqFrame &&other) noexcept
+{
+    if (this != &other) {
+        int rc = zmq_msg_move(&this->msg, &other.msg);
+        Q_ASSERT(rc == 0);
+        Q_UNUSED(rc);
+    }
+    return *this;
+}
+
+/**
+ * @brief   Destroy the frame and release its content.
+ */
+QZmqFrame::~QZmqFrame()
+{
+    int rc = zmq_msg_close(&this->msg);
+    Q_ASSERT(rc == 0);
+    Q_UNUSED(rc);
+}
+
+/**
+ * @brief   Release the content and make the frame empty.
+ * 
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ */
+bool QZmqFrame::rebuild()
+{
+    zmq_msg_close(&this->msg);
+    return zmq_msg_init(&this->msg) == 0;
+}
+
+/**
+ * @brief   Release the content and resize the frame.
+ *          Refer to the documentation of zmq_msg_init_size().
+ * 
+ * @param size      Size of the frame in bytes.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The frame is empty.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::rebuild(size_t size)
+{
+    zmq_msg_close(&this->msg);
+    if (zmq_msg_init_size(&this->msg, size) != 0) {
+        zmq_msg_init(&this->msg);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Release the content and copy the given data into the frame.
+ * 
+ * @param data      A pointer to the data to be copied.
+ * @param size      Size of the data in bytes.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The frame is empty.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::rebuild(const void *data, size_t size)
+{
+    if (!rebuild(size)) {
+        return false;
+    }
+    if (size > 0) {
+        memcpy(zmq_msg_data(&this->msg), data, size);
+    }
+    return true;
+}
+
+/**
+ * @brief   Release the content and share the data of the given byte array without copying.
+ *          A reference to the byte array is held until ØMQ releases the data, which may
+ *          happen in an I/O thread. Small byte arrays are copied.
+ * 
+ * @param data      The byte array.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The frame is empty.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::rebuild(const QByteArray &data)
+{
+    if ((size_t)data.size() <= ZERO_COPY_THRESHOLD) {
+        return rebuild(data.constData(), data.size());
+    }
+
+    // QByteArray is implicitly shared with an atomic reference count.
+    // So, the copy held by ØMQ can safely be released from another thread.
+    QByteArray *ref = new QByteArray(data);
+    if (!rebuild(const_cast<char*>(ref->constData()), ref->size(), releaseByteArray, ref)) {
+        delete ref;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Release the content and share the data of the given byte array without copying.
+ *          The shared pointer is held until ØMQ releases the data, which may happen in an
+ *          I/O thread. The byte array must not be modified until then.
+ * 
+ * @param data      A shared pointer to the byte array.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The frame is empty.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::rebuild(const QSharedPointer<QByteArray> &data)
+{
+    Q_ASSERT(!data.isNull());
+    if ((size_t)data->size() <= ZERO_COPY_THRESHOLD) {
+        return rebuild(data->constData(), data->size());
+    }
+
+    QSharedPointer<QByteArray> *ref = new QSharedPointer<QByteArray>(data);
+    if (!rebuild(const_cast<char*>(data->constData()), data->size(), releaseSharedByteArray, ref)) {
+        delete ref;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Release the content and use the given buffer without copying.
+ *          Refer to the documentation of zmq_msg_init_data().
+ * 
+ * @param data      A pointer to the buffer.
+ * @param size      Size of the buffer in bytes.
+ * @param free      Function called (possibly from an ØMQ I/O thread) to release the buffer.
+ * @param hint      Hint passed to the function that releases the buffer.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful. The frame is empty and 
+ *                  the buffer is not released.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::rebuild(void *data, size_t size, zmq_free_fn *free, void *hint)
+{
+    zmq_msg_close(&this->msg);
+    if (zmq_msg_init_data(&this->msg, data, size, free, hint) != 0) {
+        zmq_msg_init(&this->msg);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Copy the frame. The content is shared instead of being copied when possible.
+ *          Refer to the documentation of zmq_msg_copy().
+ * 
+ * @param dst       The destination frame.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ */
+bool QZmqFrame::copy(QZmqFrame &dst)
+{
+    int rc = zmq_msg_copy(&dst.msg, &this->msg);
+    return rc == 0;
+}
+
+/**
+ * @brief   Get a property of the frame.
+ *          Refer to the documentation of zmq_msg_get().
+ * 
+ * @param property  Refer to the documentation of zmq_msg_get().
+ * @param value     Value of the property.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ */
+bool QZmqFrame::get(int property, int &value)
+{
+    value = zmq_msg_get(&this->msg, property);
+    return value != -1;
+}
+
+/**
+ * @brief   Get a metadata property of the frame.
+ *          Refer to the documentation of zmq_msg_gets().
+ * 
+ * @param property  Name of the property.
+ * @return const char*  Value of the property or NULL if the property is not available.
+ */
+const char* QZmqFrame::gets(const char *property)
+{
+    return zmq_msg_gets(&this->msg, property);
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+/**
+ * @brief   Returns the routing id of the frame.
+ *          Refer to the documentation of zmq_msg_routing_id().
+ * 
+ * @return quint32  The routing id or 0 if it is not set.
+ */
+quint32 QZmqFrame::routingId()
+{
+    return zmq_msg_routing_id(&this->msg);
+}
+
+/**
+ * @brief   Set the routing id of the frame for sending through a SERVER socket.
+ *          Refer to the documentation of zmq_msg_set_routing_id().
+ * 
+ * @param routingId The routing id of the peer.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::setRoutingId(quint32 routingId)
+{
+    int rc = zmq_msg_set_routing_id(&this->msg, routingId);
+    return rc == 0;
+}
+
+/**
+ * @brief   Returns the group of the frame.
+ *          Refer to the documentation of zmq_msg_group().
+ * 
+ * @return const char*  The group or an empty string if it is not set.
+ */
+const char* QZmqFrame::group()
+{
+    return zmq_msg_group(&this->msg);
+}
+
+/**
+ * @brief   Set the group of the frame for sending through a RADIO socket.
+ *          Refer to the documentation of zmq_msg_set_group().
+ * 
+ * @param group     Name of the group.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqFrame::setGroup(const char *group)
+{
+    int rc = zmq_msg_set_group(&this->msg, group);
+    return rc == 0;
+}
+#endif
+
+/**
+ * @brief   Returns a read-only view of the content without copying it.
+ *          The content stays alive as long as the view exists, even if the frame is
+ *          reused or destroyed.
+ * 
+ * @return QZmqByteArrayView    A view of the content.
+ */
+QZmqByteArrayView QZmqFrame::toByteArrayView()
+{
+    return QZmqByteArrayView(&this->msg);
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,69 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_FRAME_H__
+#define __QZMQ_FRAME_H__
+
+#include "qzmqcommon.hpp"
+#include "qzmqbytearrayview.hpp"
+#include <zmq.h>
+#include <QByteArray>
+#include <QSharedPointer>
+
+QZMQ_BEGIN_NAMESPACE
+
+// A lightweight, move-only alternative to QZmqMessage.
+// The zmq_msg_t is stored inline, so small frames do not need any heap allocation.
+class QZMQ_API QZmqFrame
+{
+public:
+    QZmqFrame();
+    explicit QZmqFrame(size_t size);
+    QZmqFrame(const void *data, size_t size);
+    explicit QZmqFrame(const QByteArray &data);
+    QZmqFrame(QZmqFrame &&other) noexcept;
+    QZmqFrame& operator=(QZmqFrame &&other) noexcept;
+    ~QZmqFrame();
+    bool rebuild();
+    bool rebuild(size_t size);
+    bool rebuild(const void *data, size_t size);
+    bool rebuild(const QByteArray &data);
+    bool rebuild(const QSharedPointer<QByteArray> &data);
+    bool rebuild(void *data, size_t size, zmq_free_fn *free, void *hint);
+    bool copy(QZmqFrame &dst);
+    bool get(int property, int &value);
+    const char* gets(const char *property);
+#ifdef ZMQ_BUILD_DRAFT_API
+    quint32 routingId();
+    bool setRoutingId(quint32 routingId);
+    const char* group();
+    bool setGroup(const char *group);
+#endif
+    QZmqByteArrayView toByteArrayView();
+
+    inline void* data() { return zmq_msg_data(&this->msg); }
+    inline const void* data() const { return zmq_msg_data(const_cast<zmq_msg_t*>(&this->msg)); }
+    inline size_t size() const { return zmq_msg_size(&this->msg); }
+    inline bool more() const { return zmq_msg_more(&this->msg) != 0; }
+    inline zmq_msg_t* zmqMsg() { return &this->msg; }
+
+protected:
+    friend class QZmqSocket;
+    Q_DISABLE_COPY(QZmqFrame);
+    zmq_msg_t msg;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_FRAME_H__
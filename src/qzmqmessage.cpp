@@ -13,13 +13,17 @@
 // limitations under the License.
 
 #include "qzmqmessage.hpp"
+#include "qzmqmessagepool.hpp"
+#include "qzmqframe.hpp"
 #include <zmq.h>
+#include <QThread>
 
 QZMQ_BEGIN_NAMESPACE
 
 QZmqMessage::QZmqMessage(QObject *parent) : QObject(parent)
 {
     this->msg = NULL;
+    this->pool = NULL;
 }
 
 QZmqMessage::~QZmqMessage()
@@ -32,6 +36,19 @@ QZmqMessage::~QZmqMessage()
     }
 }
 
+// Messages acquired from a QZmqMessagePool are returned to the pool.
+// Other messages are deleted. Pools are not thread safe, so a pooled message that is
+// released in another thread than the one of its pool, e.g. after a queued connection,
+// is deleted as well.
+void QZmqMessage::release()
+{
+    if (this->pool != NULL && QThread::currentThread() == this->pool->thread()) {
+        this->pool->release(this);
+    } else {
+        delete this;
+    }
+}
+
 QZmqMessage* QZmqMessage::create(QObject *parent)
 {
     zmq_msg_t *msg = new zmq_msg_t();
@@ -67,6 +84,53 @@ QZmqMessage* QZmqMessage::create(zmq_msg_t *msg, QObject *parent)
     return qmsg;
 }
 
+// Takes over the content of the frame. The frame becomes empty.
+static QZmqMessage* createFromFrame(QZmqFrame &frame, QObject *parent)
+{
+    zmq_msg_t *msg = new zmq_msg_t();
+    zmq_msg_init(msg);
+    int rc = zmq_msg_move(msg, frame.zmqMsg());
+    if (rc != 0) {
+        zmq_msg_close(msg);
+        delete msg;
+        return NULL;
+    }
+    return QZmqMessage::create(msg, parent);
+}
+
+// The data is shared with the byte array instead of being copied.
+// @sa QZmqFrame::rebuild(const QByteArray &data)
+QZmqMessage* QZmqMessage::create(const QByteArray &data, QObject *parent)
+{
+    QZmqFrame frame;
+    if (!frame.rebuild(data)) {
+        return NULL;
+    }
+    return createFromFrame(frame, parent);
+}
+
+// The byte array is kept alive until ØMQ is done with the data.
+// @sa QZmqFrame::rebuild(const QSharedPointer<QByteArray> &data)
+QZmqMessage* QZmqMessage::create(const QSharedPointer<QByteArray> &data, QObject *parent)
+{
+    QZmqFrame frame;
+    if (!frame.rebuild(data)) {
+        return NULL;
+    }
+    return createFromFrame(frame, parent);
+}
+
+// Refer to the documentation of zmq_msg_init_data().
+QZmqMessage* QZmqMessage::create(void *data, size_t size, void (*free)(void *data, void *hint), void *hint,
+                                 QObject *parent)
+{
+    QZmqFrame frame;
+    if (!frame.rebuild(data, size, free, hint)) {
+        return NULL;
+    }
+    return createFromFrame(frame, parent);
+}
+
 void* QZmqMessage::data()
 {
     return zmq_msg_data(this->msg);
@@ -113,6 +177,38 @@ bool QZmqMessage::set(int property, int value)
     return rc != EINVAL;
 }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+// Routing ids are used by SERVER sockets to address CLIENT peers.
+quint32 QZmqMessage::routingId()
+{
+    return zmq_msg_routing_id(this->msg);
+}
+
+bool QZmqMessage::setRoutingId(quint32 routingId)
+{
+    int rc = zmq_msg_set_routing_id(this->msg, routingId);
+    return rc == 0;
+}
+
+// Groups are used by RADIO and DISH sockets.
+const char* QZmqMessage::group()
+{
+    return zmq_msg_group(this->msg);
+}
+
+bool QZmqMessage::setGroup(const char *group)
+{
+    int rc = zmq_msg_set_group(this->msg, group);
+    return rc == 0;
+}
+#endif
+
+// The content is shared with the view instead of being copied.
+QZmqByteArrayView QZmqMessage::toByteArrayView()
+{
+    return QZmqByteArrayView(this->msg);
+}
+
 zmq_msg_t* QZmqMessage::zmqMsg()
 {
     return this->msg;
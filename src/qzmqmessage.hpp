@@ -16,31 +16,49 @@
 #define __QZMQ_MESSAGE_H__
 
 #include "qzmqcommon.hpp"
+#include "qzmqbytearrayview.hpp"
 #include <QObject>
+#include <QByteArray>
+#include <QSharedPointer>
 
 QZMQ_BEGIN_NAMESPACE
 
 struct zmq_msg_t;
+class QZmqMessagePool;
 class QZMQ_API QZmqMessage : public QObject
 {
 public:
     static QZmqMessage* create(QObject *parent=nullptr);
     static QZmqMessage* create(size_t size, QObject *parent=nullptr);
     static QZmqMessage* create(zmq_msg_t *msg, QObject *parent=nullptr);
+    static QZmqMessage* create(const QByteArray &data, QObject *parent=nullptr);
+    static QZmqMessage* create(const QSharedPointer<QByteArray> &data, QObject *parent=nullptr);
+    static QZmqMessage* create(void *data, size_t size, void (*free)(void *data, void *hint), void *hint,
+                               QObject *parent=nullptr);
     virtual ~QZmqMessage();
+    void release();
     void* data() ;
     bool copy(QZmqMessage *dst);
     bool move(QZmqMessage *dst);
     bool more();
     size_t size();
+    QZmqByteArrayView toByteArrayView();
     const char* gets(const char *property);
     bool get(int property, int &value);
     bool set(int property, int value);
+#ifdef ZMQ_BUILD_DRAFT_API
+    quint32 routingId();
+    bool setRoutingId(quint32 routingId);
+    const char* group();
+    bool setGroup(const char *group);
+#endif
     zmq_msg_t* zmqMsg();
 protected:
     friend class QZmqSocket;
+    friend class QZmqMessagePool;
     QZmqMessage(QObject *parent=nullptr);
     zmq_msg_t *msg;
+    QZmqMessagePool *pool;
 };
 
 QZMQ_END_NAMESPACE
@@ -0,0 +1,238 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqmessagepool.hpp"
+#include "qzmqmessage.hpp"
+#include <zmq.h>
+#include <QThread>
+#include <QThreadStorage>
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr int DEFAULT_POOL_CAPACITY = 4096;
+
+/**
+ * @brief   Construct a new QZmqMessagePool::QZmqMessagePool object
+ * 
+ * @param parent Parent object of the pool.
+ */
+QZmqMessagePool::QZmqMessagePool(QObject *parent) : QObject(parent)
+{
+    this->maxMessages = DEFAULT_POOL_CAPACITY;
+    this->hitCount = 0;
+    this->missCount = 0;
+}
+
+/**
+ * @brief   Destroy the QZmqMessagePool::QZmqMessagePool object.
+ *          Only the messages in the pool are destroyed. Messages that are not released
+ *          must not be released after the pool is destroyed.
+ */
+QZmqMessagePool::~QZmqMessagePool()
+{
+    for (QZmqMessage *msg : this->messages) {
+        msg->pool = NULL;
+        delete msg;
+    }
+    this->messages.clear();
+}
+
+/**
+ * @brief   Returns the message pool of the calling thread.
+ *          The pool is created on first use and destroyed when the thread exits.
+ * 
+ * @return QZmqMessagePool*  A pointer to the pool of the calling thread.
+ */
+QZmqMessagePool* QZmqMessagePool::instance()
+{
+    // Messages are recycled in the thread that uses them. So, no locks are needed.
+    static QThreadStorage<QZmqMessagePool*> pools;
+    if (!pools.hasLocalData()) {
+        pools.setLocalData(new QZmqMessagePool());
+    }
+    return pools.localData();
+}
+
+/**
+ * @brief   Take a message from the pool or create a new one if the pool is empty.
+ * 
+ * @return QZmqMessage*  A pointer to an empty message.
+ *                       NULL is returned if the message creation is failed.
+ */
+QZmqMessage* QZmqMessagePool::take()
+{
+    if (!this->messages.isEmpty()) {
+        this->hitCount++;
+        QZmqMessage *msg = this->messages.last();
+        this->messages.removeLast();
+        return msg;
+    }
+
+    this->missCount++;
+    QZmqMessage *msg = QZmqMessage::create();
+    if (msg != NULL) {
+        msg->pool = this;
+    }
+    return msg;
+}
+
+/**
+ * @brief   Get an empty message from the pool.
+ *          Use QZmqMessage::release() or QZmqMessagePool::release() to return the message
+ *          to the pool once it is no longer needed.
+ * 
+ * @return QZmqMessage*  A pointer to an empty message.
+ *                       NULL is returned if the message creation is failed.
+ */
+QZmqMessage* QZmqMessagePool::acquire()
+{
+    return take();
+}
+
+/**
+ * @brief   Get a message of the given size from the pool.
+ *          Refer to the documentation of zmq_msg_init_size().
+ * 
+ * @param size  Size of the message in bytes.
+ * @return QZmqMessage*  A pointer to the message.
+ *                       NULL is returned if the message initialization is failed.
+ *                       Use QZmqError::getLastError() to get the error code.
+ */
+QZmqMessage* QZmqMessagePool::acquire(size_t size)
+{
+    QZmqMessage *msg = take();
+    if (msg == NULL) {
+        return NULL;
+    }
+
+    // Pooled messages are always initialized and empty.
+    // Closing an empty message does not free anything.
+    zmq_msg_close(msg->msg);
+    if (zmq_msg_init_size(msg->msg, size) != 0) {
+        zmq_msg_init(msg->msg);
+        release(msg);
+        return NULL;
+    }
+    return msg;
+}
+
+/**
+ * @brief   Return a message to the pool.
+ *          The content of the message is released. The message is destroyed
+ *          if the pool is full.
+ *          Must be called in the thread of the pool. Use QZmqMessage::release() for
+ *          messages that are passed to other threads, which deletes them there.
+ * 
+ * @param msg   A pointer to a message acquired from this pool.
+ */
+void QZmqMessagePool::release(QZmqMessage *msg)
+{
+    Q_ASSERT(msg != NULL);
+    Q_ASSERT(msg->pool == this);
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    if (this->messages.size() >= this->maxMessages) {
+        msg->pool = NULL;
+        delete msg;
+        return;
+    }
+
+    int rc = zmq_msg_close(msg->msg);
+    Q_ASSERT(rc == 0);
+    rc = zmq_msg_init(msg->msg);
+    Q_ASSERT(rc == 0);
+    Q_UNUSED(rc);
+
+    this->messages.append(msg);
+}
+
+/**
+ * @brief   Pre-construct messages so that the first acquisitions do not allocate.
+ * 
+ * @param count     Number of messages to be available in the pool.
+ */
+void QZmqMessagePool::reserve(int count)
+{
+    count = qMin(count, this->maxMessages);
+    this->messages.reserve(count);
+    while (this->messages.size() < count) {
+        QZmqMessage *msg = QZmqMessage::create();
+        if (msg == NULL) {
+            break;
+        }
+        msg->pool = this;
+        this->messages.append(msg);
+    }
+}
+
+/**
+ * @brief   Returns the number of messages available in the pool.
+ * 
+ * @return int  Number of messages available.
+ */
+int QZmqMessagePool::available()
+{
+    return this->messages.size();
+}
+
+/**
+ * @brief   Returns the maximum number of messages kept in the pool.
+ *          @sa QZmqMessagePool::setCapacity()
+ * 
+ * @return int  Maximum number of messages kept in the pool.
+ */
+int QZmqMessagePool::capacity()
+{
+    return this->maxMessages;
+}
+
+/**
+ * @brief   Set the maximum number of messages kept in the pool.
+ *          Messages released to a full pool are destroyed.
+ *          @sa QZmqMessagePool::capacity()
+ * 
+ * @param capacity  Maximum number of messages kept in the pool.
+ */
+void QZmqMessagePool::setCapacity(int capacity)
+{
+    this->maxMessages = capacity;
+    while (this->messages.size() > this->maxMessages) {
+        QZmqMessage *msg = this->messages.last();
+        this->messages.removeLast();
+        msg->pool = NULL;
+        delete msg;
+    }
+}
+
+/**
+ * @brief   Returns the number of acquisitions served from the pool.
+ * 
+ * @return quint64  Number of pool hits.
+ */
+quint64 QZmqMessagePool::hits()
+{
+    return this->hitCount;
+}
+
+/**
+ * @brief   Returns the number of acquisitions that required creating a new message.
+ * 
+ * @return quint64  Number of pool misses.
+ */
+quint64 QZmqMessagePool::misses()
+{
+    return this->missCount;
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,53 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_MESSAGE_POOL_H__
+#define __QZMQ_MESSAGE_POOL_H__
+
+#include "qzmqcommon.hpp"
+#include <QObject>
+#include <QVector>
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqMessage;
+class QZMQ_API QZmqMessagePool : public QObject
+{
+public:
+    static QZmqMessagePool* instance();
+    virtual ~QZmqMessagePool();
+    QZmqMessage* acquire();
+    QZmqMessage* acquire(size_t size);
+    void release(QZmqMessage *msg);
+    void reserve(int count);
+    int available();
+    int capacity();
+    void setCapacity(int capacity);
+    quint64 hits();
+    quint64 misses();
+
+protected:
+    QZmqMessagePool(QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqMessagePool);
+    QZmqMessage* take();
+
+    QVector<QZmqMessage*> messages;
+    int maxMessages;
+    quint64 hitCount;
+    quint64 missCount;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_MESSAGE_POOL_H__
@@ -0,0 +1,243 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqmonitor.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqerror.hpp"
+#include <zmq.h>
+#include <QByteArray>
+#include <cerrno>
+#include <cstring>
+
+QZMQ_BEGIN_NAMESPACE
+
+/**
+ * @brief   Construct a new QZmqMonitor::QZmqMonitor object.
+ *          Use QZmqSocket::enableMonitor() to create monitors.
+ * 
+ * @param socket    The monitored socket. It is also the parent of the monitor.
+ */
+QZmqMonitor::QZmqMonitor(QZmqSocket *socket) : QObject(socket)
+{
+    this->monitored = socket;
+    this->pair = NULL;
+    this->clock.start();
+}
+
+/**
+ * @brief   Destroy the QZmqMonitor::QZmqMonitor object.
+ *          Monitoring of the socket is stopped.
+ */
+QZmqMonitor::~QZmqMonitor()
+{
+    zmq_socket_monitor(this->monitored->zmqSocket(), NULL, 0);
+
+    if (this->pair != NULL) {
+        delete this->pair;
+        this->pair = NULL;
+    }
+}
+
+/**
+ * @brief   Start monitoring the socket.
+ * 
+ * @param context   The context of the monitored socket.
+ * @param events    Events to be monitored. Refer to the documentation of zmq_socket_monitor().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqMonitor::start(QZmqContext *context, int events)
+{
+    // The monitor endpoint must belong to the context of the monitored socket.
+    QByteArray endpoint = "inproc://qzmq-monitor-" + QByteArray::number(reinterpret_cast<quintptr>(this), 16);
+    int rc = zmq_socket_monitor(this->monitored->zmqSocket(), endpoint.constData(), events);
+    if (rc != 0) {
+        return false;
+    }
+
+    this->pair = QZmqSocket::create(context, ZMQ_PAIR, this);
+    if (this->pair == NULL || !this->pair->connect(endpoint.constData())) {
+        return false;
+    }
+    this->pair->setMultipartMode(true);
+    QObject::connect(this->pair, &QZmqSocket::onMultipartMessage, this, &QZmqMonitor::onMonitorMessage);
+    return true;
+}
+
+/**
+ * @brief   Returns the monitored socket.
+ * 
+ * @return QZmqSocket*  A pointer to the monitored socket.
+ */
+QZmqSocket* QZmqMonitor::socket()
+{
+    return this->monitored;
+}
+
+/**
+ * @brief   Returns the connection statistics of an endpoint.
+ *          Statistics of bound endpoints aggregate all accepted peers.
+ * 
+ * @param endpoint  The endpoint as given to connect or bind.
+ * @return QZmqEndpointStats    Statistics of the endpoint. All zero if the endpoint is not seen yet.
+ */
+QZmqEndpointStats QZmqMonitor::stats(const QString &endpoint)
+{
+    return this->statistics.value(endpoint, QZmqEndpointStats());
+}
+
+/**
+ * @brief   Returns the connection statistics of all endpoints seen so far.
+ * 
+ * @return QHash<QString, QZmqEndpointStats>    Statistics by endpoint.
+ */
+QHash<QString, QZmqEndpointStats> QZmqMonitor::endpointStats()
+{
+    return this->statistics;
+}
+
+/**
+ * @brief   Returns the statistics of an endpoint for updating.
+ * 
+ * @param endpoint  The endpoint.
+ * @return QZmqEndpointStats&   Statistics of the endpoint.
+ */
+QZmqEndpointStats& QZmqMonitor::endpoint(const QString &endpoint)
+{
+    auto it = this->statistics.find(endpoint);
+    if (it == this->statistics.end()) {
+        QZmqEndpointStats stats;
+        memset(&stats, 0, sizeof(stats));
+        it = this->statistics.insert(endpoint, stats);
+    }
+    return it.value();
+}
+
+/**
+ * @brief   Remove a connection from the handshakes in progress of an endpoint.
+ *          libzmq does not report the file descriptor with the handshake events.
+ *          In that case, the oldest connection of the endpoint is taken.
+ * 
+ * @param endpoint  The endpoint.
+ * @param fd        File descriptor of the connection or -1 if it is not known.
+ * @return qint64   Time at which the connection was established or -1 if there is none.
+ */
+qint64 QZmqMonitor::takeHandshake(const QString &endpoint, int fd)
+{
+    auto it = this->handshakes.find(endpoint);
+    if (it == this->handshakes.end()) {
+        return -1;
+    }
+
+    QVector<PendingHandshake> &pending = it.value();
+    int index = fd < 0 && !pending.isEmpty() ? 0 : -1;
+    for (int i = 0; index < 0 && i < pending.size(); i++) {
+        if (pending[i].fd == fd) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        return -1;
+    }
+
+    qint64 start = pending[index].start;
+    pending.remove(index);
+    if (pending.isEmpty()) {
+        this->handshakes.erase(it);
+    }
+    return start;
+}
+
+/**
+ * @brief   This is the slot (function) for the events of the monitored socket.
+ * 
+ * @param socket    The PAIR socket connected to the monitor endpoint.
+ * @param msg       [16 bit event, 32 bit value][endpoint]
+ */
+void QZmqMonitor::onMonitorMessage(QZmqSocket *socket, QZmqMultipartMessage *msg)
+{
+    if (msg->size() != 2 || msg->at(0).size() != sizeof(quint16) + sizeof(quint32)) {
+        delete msg;
+        return;
+    }
+
+    quint16 event;
+    quint32 value;
+    const char *data = static_cast<const char*>(msg->at(0).data());
+    memcpy(&event, data, sizeof(event));
+    memcpy(&value, data + sizeof(event), sizeof(value));
+    QString address = QString::fromUtf8(static_cast<const char*>(msg->at(1).data()), msg->at(1).size());
+    delete msg;
+
+    qint64 now = this->clock.nsecsElapsed() / 1000;
+    QZmqEndpointStats &stats = endpoint(address);
+    switch (event) {
+        case ZMQ_EVENT_CONNECTED:
+        case ZMQ_EVENT_ACCEPTED:
+            // Peers accepted on a bound endpoint are separate connections, not reconnects.
+            if (event == ZMQ_EVENT_CONNECTED && this->disconnected.remove(address)) {
+                stats.reconnects++;
+            }
+            stats.connects++;
+            stats.connectedAt = now;
+            // The value of the event is the file descriptor of the connection.
+            this->handshakes[address].append({ static_cast<int>(value), now });
+            if (event == ZMQ_EVENT_CONNECTED) {
+                emit onConnected(this->monitored, address);
+            } else {
+                emit onAccepted(this->monitored, address);
+            }
+            break;
+        case ZMQ_EVENT_CONNECT_RETRIED:
+            stats.connectRetries++;
+            emit onConnectRetried(this->monitored, address, static_cast<int>(value));
+            break;
+        case ZMQ_EVENT_DISCONNECTED:
+            stats.disconnects++;
+            this->disconnected.insert(address);
+            takeHandshake(address, static_cast<int>(value));
+            emit onDisconnected(this->monitored, address);
+            break;
+        case ZMQ_EVENT_HANDSHAKE_SUCCEEDED: {
+            qint64 start = takeHandshake(address, value != 0 ? static_cast<int>(value) : -1);
+            qint64 duration = start >= 0 ? now - start : 0;
+            stats.handshakes++;
+            if (start >= 0) {
+                stats.lastHandshakeTime = duration;
+                stats.totalHandshakeTime += duration;
+                if (duration > stats.maxHandshakeTime) {
+                    stats.maxHandshakeTime = duration;
+                }
+            }
+            emit onHandshakeSucceeded(this->monitored, address, duration);
+            break;
+        }
+        case ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL:
+        case ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL:
+        case ZMQ_EVENT_HANDSHAKE_FAILED_AUTH:
+            // The value of the event is the error code.
+            takeHandshake(address, -1);
+            stats.handshakeFailures++;
+            emit onHandshakeFailed(this->monitored, address, event, static_cast<int>(value));
+            break;
+        default:
+            break;
+    }
+
+    emit onEvent(this->monitored, event, static_cast<int>(value), address);
+}
+
+QZMQ_END_NAMESPACE
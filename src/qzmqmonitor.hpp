@@ -0,0 +1,91 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_MONITOR_H__
+#define __QZMQ_MONITOR_H__
+
+#include "qzmqcommon.hpp"
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+
+QZMQ_BEGIN_NAMESPACE
+
+// Connection statistics of an endpoint. Times are in microseconds.
+struct QZmqEndpointStats
+{
+    quint64 connects;
+    quint64 reconnects;
+    quint64 connectRetries;
+    quint64 disconnects;
+    quint64 handshakes;
+    quint64 handshakeFailures;
+    qint64 lastHandshakeTime;
+    qint64 maxHandshakeTime;
+    qint64 totalHandshakeTime;
+    qint64 connectedAt;
+};
+
+class QZmqSocket;
+class QZmqContext;
+class QZmqMultipartMessage;
+class QZMQ_API QZmqMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~QZmqMonitor();
+    QZmqSocket* socket();
+    QZmqEndpointStats stats(const QString &endpoint);
+    QHash<QString, QZmqEndpointStats> endpointStats();
+
+signals:
+    void onEvent(QZmqSocket *socket, int event, int value, const QString &endpoint);
+    void onConnected(QZmqSocket *socket, const QString &endpoint);
+    void onConnectRetried(QZmqSocket *socket, const QString &endpoint, int interval);
+    void onAccepted(QZmqSocket *socket, const QString &endpoint);
+    void onDisconnected(QZmqSocket *socket, const QString &endpoint);
+    void onHandshakeSucceeded(QZmqSocket *socket, const QString &endpoint, qint64 duration);
+    void onHandshakeFailed(QZmqSocket *socket, const QString &endpoint, int event, int error);
+
+protected slots:
+    void onMonitorMessage(QZmqSocket *socket, QZmqMultipartMessage *msg);
+
+protected:
+    friend class QZmqSocket;
+    QZmqMonitor(QZmqSocket *socket);
+    Q_DISABLE_COPY(QZmqMonitor);
+    bool start(QZmqContext *context, int events);
+    QZmqEndpointStats& endpoint(const QString &endpoint);
+
+    struct PendingHandshake
+    {
+        int fd;
+        qint64 start;
+    };
+    qint64 takeHandshake(const QString &endpoint, int fd);
+
+    QZmqSocket *monitored;
+    QZmqSocket *pair;
+    QHash<QString, QZmqEndpointStats> statistics;
+    QHash<QString, QVector<PendingHandshake> > handshakes;  // Oldest connection first
+    QSet<QString> disconnected;     // Connected endpoints that lost their connection
+    QElapsedTimer clock;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_MONITOR_H__
@@ -0,0 +1,210 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqmultipartmessage.hpp"
+
+QZMQ_BEGIN_NAMESPACE
+
+/**
+ * @brief   Construct an empty multipart message.
+ */
+QZmqMultipartMessage::QZmqMultipartMessage()
+{
+    this->count = 0;
+}
+
+/**
+ * @brief   Move constructor. The other message becomes empty.
+ * 
+ * @param other The message to be moved.
+ */
+QZmqMultipartMessage::QZmqMultipartMessage(QZmqMultipartMessage &&other) noexcept
+{
+    this->count = 0;
+    *this = std::move(other);
+}
+
+/**
+ * @brief   Move assignment. The frames of this message are released and 
+ *          the other message becomes empty.
+ * 
+ * @param other The message to be moved.
+ * @return QZmqMultipartMessage&    Reference to this message.
+ */
+QZmqMultipartMessage& QZmqMultipartMessage::operator=(QZmqMultipartMessage &&other) noexcept
+{
+    if (this == &other) {
+        return *this;
+    }
+
+    clear();
+    for (int i = 0; i < other.count && i < PREALLOC; i++) {
+        this->frames[i] = std::move(other.frames[i]);
+    }
+    this->extraFrames = std::move(other.extraFrames);
+    this->count = other.count;
+
+    other.extraFrames.clear();
+    other.count = 0;
+    return *this;
+}
+
+/**
+ * @brief   Destroy the message and release all frames.
+ */
+QZmqMultipartMessage::~QZmqMultipartMessage()
+{
+
+}
+
+/**
+ * @brief   Append an empty frame.
+ * 
+ * @return QZmqFrame&   Reference to the appended frame.
+ */
+QZmqFrame& QZmqMultipartMessage::append()
+{
+    if (this->count < PREALLOC) {
+        return this->frames[this->count++];
+    }
+
+    this->extraFrames.emplace_back();
+    this->count++;
+    return this->extraFrames.back();
+}
+
+/**
+ * @brief   Append a frame. The given frame becomes empty.
+ * 
+ * @param frame The frame to be appended.
+ */
+void QZmqMultipartMessage::append(QZmqFrame &&frame)
+{
+    append() = std::move(frame);
+}
+
+/**
+ * @brief   Append a frame with a copy of the given data.
+ * 
+ * @param data      A pointer to the data to be copied.
+ * @param size      Size of the data in bytes.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqMultipartMessage::append(const void *data, size_t size)
+{
+    if (!append().rebuild(data, size)) {
+        removeLast();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Insert a frame before the first frame. The given frame becomes empty.
+ *          This is useful for adding envelopes such as routing ids.
+ * 
+ * @param frame The frame to be inserted.
+ */
+void QZmqMultipartMessage::prepend(QZmqFrame &&frame)
+{
+    append();
+    for (int i = this->count - 1; i > 0; i--) {
+        at(i) = std::move(at(i - 1));
+    }
+    at(0) = std::move(frame);
+}
+
+/**
+ * @brief   Remove the first frame and return it.
+ *          This is useful for stripping envelopes such as routing ids.
+ * 
+ * @return QZmqFrame    The first frame.
+ */
+QZmqFrame QZmqMultipartMessage::takeFirst()
+{
+    Q_ASSERT(this->count > 0);
+
+    QZmqFrame first(std::move(at(0)));
+    for (int i = 1; i < this->count; i++) {
+        at(i - 1) = std::move(at(i));
+    }
+    removeLast();
+    return first;
+}
+
+/**
+ * @brief   Remove the first frames and release their content.
+ *
+ * @param n     Number of frames to be removed.
+ */
+void QZmqMultipartMessage::removeFirst(int n)
+{
+    Q_ASSERT(n >= 0 && n <= this->count);
+
+    if (n == 0) {
+        return;
+    }
+    for (int i = n; i < this->count; i++) {
+        at(i - n) = std::move(at(i));
+    }
+    for (int i = 0; i < n; i++) {
+        removeLast();
+    }
+}
+
+/**
+ * @brief   Remove the last frame and release its content.
+ */
+void QZmqMultipartMessage::removeLast()
+{
+    Q_ASSERT(this->count > 0);
+
+    this->count--;
+    if (this->count < PREALLOC) {
+        this->frames[this->count].rebuild();
+    } else {
+        this->extraFrames.pop_back();
+    }
+}
+
+/**
+ * @brief   Remove all frames and release their content.
+ *          The inline frame storage is kept.
+ */
+void QZmqMultipartMessage::clear()
+{
+    for (int i = 0; i < this->count && i < PREALLOC; i++) {
+        this->frames[i].rebuild();
+    }
+    this->extraFrames.clear();
+    this->count = 0;
+}
+
+/**
+ * @brief   Returns the total size of all frames in bytes.
+ * 
+ * @return size_t   Total size in bytes.
+ */
+size_t QZmqMultipartMessage::totalSize() const
+{
+    size_t total = 0;
+    for (int i = 0; i < this->count; i++) {
+        total += at(i).size();
+    }
+    return total;
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,67 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_MULTIPART_MESSAGE_H__
+#define __QZMQ_MULTIPART_MESSAGE_H__
+
+#include "qzmqcommon.hpp"
+#include "qzmqframe.hpp"
+#include <QMetaType>
+#include <vector>
+
+QZMQ_BEGIN_NAMESPACE
+
+// A complete multipart message. The first few frames are stored inline, so typical
+// envelopes (e.g. ROUTER/DEALER) do not need any allocation for the frame storage.
+class QZMQ_API QZmqMultipartMessage
+{
+public:
+    QZmqMultipartMessage();
+    QZmqMultipartMessage(QZmqMultipartMessage &&other) noexcept;
+    QZmqMultipartMessage& operator=(QZmqMultipartMessage &&other) noexcept;
+    ~QZmqMultipartMessage();
+    QZmqFrame& append();
+    void append(QZmqFrame &&frame);
+    bool append(const void *data, size_t size);
+    void prepend(QZmqFrame &&frame);
+    QZmqFrame takeFirst();
+    void removeFirst(int n);
+    void removeLast();
+    void clear();
+    size_t totalSize() const;
+
+    inline int size() const { return this->count; }
+    inline bool isEmpty() const { return this->count == 0; }
+    inline QZmqFrame& at(int i) { return i < PREALLOC ? this->frames[i] : this->extraFrames[i - PREALLOC]; }
+    inline const QZmqFrame& at(int i) const { return i < PREALLOC ? this->frames[i] : this->extraFrames[i - PREALLOC]; }
+    inline QZmqFrame& operator[](int i) { return at(i); }
+    inline const QZmqFrame& operator[](int i) const { return at(i); }
+
+protected:
+    Q_DISABLE_COPY(QZmqMultipartMessage);
+    static const int PREALLOC = 4;
+    QZmqFrame frames[PREALLOC];
+    std::vector<QZmqFrame> extraFrames;
+    int count;
+};
+
+QZMQ_END_NAMESPACE
+
+#ifdef QZMQ_NAMESPACE
+Q_DECLARE_METATYPE(QZMQ_NAMESPACE::QZmqMultipartMessage*)
+#else
+Q_DECLARE_METATYPE(QZmqMultipartMessage*)
+#endif
+
+#endif // __QZMQ_MULTIPART_MESSAGE_H__
@@ -0,0 +1,413 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqproxy.hpp"
+#include "qzmqcontext.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqerror.hpp"
+#include <zmq.h>
+#include <QByteArray>
+#include <QThread>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+
+QZMQ_BEGIN_NAMESPACE
+
+// The thread that runs the blocking zmq_proxy_steerable() call.
+class QZmqProxyThread : public QThread
+{
+public:
+    QZmqProxyThread(QZmqProxy *proxy) : QThread(proxy), proxy(proxy) {}
+
+protected:
+    void run() override
+    {
+        this->proxy->run();
+    }
+
+    QZmqProxy *proxy;
+};
+
+/**
+ * @brief   Construct a new QZmqProxy::QZmqProxy object
+ * 
+ * @param parent Parent object of the proxy.
+ */
+QZmqProxy::QZmqProxy(QObject *parent) : QObject(parent)
+{
+    this->frontend = NULL;
+    this->backend = NULL;
+    this->capture = NULL;
+    this->control = NULL;
+    this->command = NULL;
+    this->thread = NULL;
+    this->statisticsTimer = NULL;
+    this->error = 0;
+}
+
+/**
+ * @brief   Destroy the QZmqProxy::QZmqProxy object.
+ *          A running proxy is terminated and waited for.
+ */
+QZmqProxy::~QZmqProxy()
+{
+    if (this->thread != NULL) {
+        if (this->thread->isRunning()) {
+            terminate();
+            this->thread->wait();
+        }
+        delete this->thread;
+        this->thread = NULL;
+    }
+
+    // The sockets are closed by the proxy thread if the proxy was started.
+    closeSockets();
+
+    if (this->command != NULL) {
+        delete this->command;
+        this->command = NULL;
+    }
+}
+
+/**
+ * @brief   Create a proxy. The proxy is started with QZmqProxy::start() after
+ *          the frontend and the backend are bound or connected.
+ *          Refer to the documentation of zmq_proxy_steerable().
+ * 
+ * @param frontendType  Type of the frontend socket. Refer to the documentation of zmq_socket().
+ * @param backendType   Type of the backend socket. Refer to the documentation of zmq_socket().
+ * @param parent        Parent object of the created proxy.
+ * @return QZmqProxy*   A pointer to the created proxy. 
+ *                      NULL is returned if the proxy creation is failed.
+ *                      Use QZmqError::getLastError() to get the error code.
+ */
+QZmqProxy* QZmqProxy::create(int frontendType, int backendType, QObject *parent)
+{
+    void *context = QZmqContext::instance()->zmqContext();
+    QZmqProxy *proxy = new QZmqProxy(parent);
+    QByteArray endpoint = "inproc://qzmq-proxy-" + QByteArray::number(reinterpret_cast<quintptr>(proxy), 16);
+
+    proxy->frontend = zmq_socket(context, frontendType);
+    proxy->backend = zmq_socket(context, backendType);
+    proxy->control = zmq_socket(context, ZMQ_PAIR);
+    if (proxy->frontend == NULL || proxy->backend == NULL || proxy->control == NULL ||
+        zmq_bind(proxy->control, endpoint.constData()) != 0) {
+        int error = QZmqError::getLastError();
+        delete proxy;
+        errno = error;
+        return NULL;
+    }
+
+    // Commands are sent and statistics are received in the thread of the proxy object.
+    proxy->command = QZmqSocket::create(ZMQ_PAIR, proxy);
+    if (proxy->command == NULL || !proxy->command->connect(endpoint.constData())) {
+        int error = QZmqError::getLastError();
+        delete proxy;
+        errno = error;
+        return NULL;
+    }
+    proxy->command->setMultipartMode(true);
+    QObject::connect(proxy->command, &QZmqSocket::onMultipartMessage, proxy, &QZmqProxy::onControlMessage);
+
+    proxy->statisticsTimer = new QTimer(proxy);
+    QObject::connect(proxy->statisticsTimer, &QTimer::timeout, proxy, &QZmqProxy::requestStatistics);
+
+    static int statisticsTypeId = qRegisterMetaType<QZmqProxyStatistics>();
+    Q_UNUSED(statisticsTypeId);
+
+    return proxy;
+}
+
+/**
+ * @brief   Accept incoming connections on the frontend socket.
+ *          Must be called before the proxy is started.
+ * 
+ * @param address   Refer to the documentation of zmq_bind().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqProxy::bindFrontend(const char *address)
+{
+    Q_ASSERT(this->thread == NULL);
+    return zmq_bind(this->frontend, address) == 0;
+}
+
+/**
+ * @brief   Create outgoing connection from the frontend socket.
+ *          Must be called before the proxy is started.
+ * 
+ * @param address   Refer to the documentation of zmq_connect().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqProxy::connectFrontend(const char *address)
+{
+    Q_ASSERT(this->thread == NULL);
+    return zmq_connect(this->frontend, address) == 0;
+}
+
+/**
+ * @brief   Accept incoming connections on the backend socket.
+ *          Must be called before the proxy is started.
+ * 
+ * @param address   Refer to the documentation of zmq_bind().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqProxy::bindBackend(const char *address)
+{
+    Q_ASSERT(this->thread == NULL);
+    return zmq_bind(this->backend, address) == 0;
+}
+
+/**
+ * @brief   Create outgoing connection from the backend socket.
+ *          Must be called before the proxy is started.
+ * 
+ * @param address   Refer to the documentation of zmq_connect().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqProxy::connectBackend(const char *address)
+{
+    Q_ASSERT(this->thread == NULL);
+    return zmq_connect(this->backend, address) == 0;
+}
+
+/**
+ * @brief   Publish all proxied messages on a PUB socket bound to the given address.
+ *          Must be called before the proxy is started.
+ * 
+ * @param address   Refer to the documentation of zmq_bind().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqProxy::setCapture(const char *address)
+{
+    Q_ASSERT(this->thread == NULL);
+
+    if (this->capture == NULL) {
+        this->capture = zmq_socket(QZmqContext::instance()->zmqContext(), ZMQ_PUB);
+        if (this->capture == NULL) {
+            return false;
+        }
+    }
+    return zmq_bind(this->capture, address) == 0;
+}
+
+/**
+ * @brief   Returns the underlying raw frontend socket.
+ *          It can be used to set socket options before the proxy is started.
+ * 
+ * @return void*    A pointer to the raw socket.
+ */
+void* QZmqProxy::frontendSocket()
+{
+    return this->frontend;
+}
+
+/**
+ * @brief   Returns the underlying raw backend socket.
+ *          It can be used to set socket options before the proxy is started.
+ * 
+ * @return void*    A pointer to the raw socket.
+ */
+void* QZmqProxy::backendSocket()
+{
+    return this->backend;
+}
+
+/**
+ * @brief   Start the proxy in its own thread.
+ *          The sockets of the proxy are owned by the proxy thread from now on.
+ * 
+ * @return true     If the proxy is started.
+ * @return false    If the proxy has already been started.
+ */
+bool QZmqProxy::start()
+{
+    if (this->thread != NULL) {
+        return false;
+    }
+
+    this->thread = new QZmqProxyThread(this);
+    QObject::connect(this->thread, &QThread::finished, this, &QZmqProxy::onThreadFinished);
+    this->thread->start();
+    return true;
+}
+
+/**
+ * @brief   See if the proxy thread is running.
+ * 
+ * @return true     If the proxy is running.
+ * @return false    If the proxy is not started yet or has finished.
+ */
+bool QZmqProxy::isRunning()
+{
+    return this->thread != NULL && this->thread->isRunning();
+}
+
+/**
+ * @brief   Block until the proxy thread finishes.
+ */
+void QZmqProxy::wait()
+{
+    if (this->thread != NULL) {
+        this->thread->wait();
+    }
+}
+
+/**
+ * @brief   Returns the interval of the statistics requests.
+ *          @sa QZmqProxy::setStatisticsInterval()
+ * 
+ * @return int  Interval in milliseconds or 0 if statistics are not requested periodically.
+ */
+int QZmqProxy::statisticsInterval()
+{
+    return this->statisticsTimer->isActive() ? this->statisticsTimer->interval() : 0;
+}
+
+/**
+ * @brief   Request statistics periodically. QZmqProxy::onStatistics() signal is emitted
+ *          with every reply.
+ * 
+ * @param msec  Interval in milliseconds. 0 stops the periodic requests.
+ */
+void QZmqProxy::setStatisticsInterval(int msec)
+{
+    if (msec > 0) {
+        this->statisticsTimer->start(msec);
+    } else {
+        this->statisticsTimer->stop();
+    }
+}
+
+/**
+ * @brief   Pause forwarding messages.
+ */
+void QZmqProxy::pause()
+{
+    sendCommand("PAUSE");
+}
+
+/**
+ * @brief   Resume forwarding messages.
+ */
+void QZmqProxy::resume()
+{
+    sendCommand("RESUME");
+}
+
+/**
+ * @brief   Terminate the proxy. QZmqProxy::onFinished() signal is emitted once the
+ *          proxy thread finishes.
+ */
+void QZmqProxy::terminate()
+{
+    sendCommand("TERMINATE");
+}
+
+/**
+ * @brief   Request the message and byte counters of the proxy.
+ *          QZmqProxy::onStatistics() signal is emitted when the reply arrives.
+ */
+void QZmqProxy::requestStatistics()
+{
+    sendCommand("STATISTICS");
+}
+
+/**
+ * @brief   Send a command to the control socket of the proxy.
+ * 
+ * @param command   The command.
+ */
+void QZmqProxy::sendCommand(const char *command)
+{
+    if (this->thread == NULL || this->thread->isFinished()) {
+        return;
+    }
+    this->command->send(QZmqFrame(command, strlen(command)));
+}
+
+/**
+ * @brief   This is the slot (function) for replies from the control socket of the proxy.
+ * 
+ * @param socket    The command socket.
+ * @param msg       Eight 64 bit counters.
+ */
+void QZmqProxy::onControlMessage(QZmqSocket *socket, QZmqMultipartMessage *msg)
+{
+    constexpr int COUNTERS = sizeof(QZmqProxyStatistics) / sizeof(quint64);
+
+    if (msg->size() == COUNTERS) {
+        quint64 counters[COUNTERS];
+        bool valid = true;
+        for (int i = 0; i < COUNTERS && valid; i++) {
+            valid = msg->at(i).size() == sizeof(quint64);
+            if (valid) {
+                memcpy(&counters[i], msg->at(i).data(), sizeof(quint64));
+            }
+        }
+        if (valid) {
+            QZmqProxyStatistics stats;
+            memcpy(&stats, counters, sizeof(stats));
+            emit onStatistics(this, stats);
+        }
+    }
+    delete msg;
+}
+
+/**
+ * @brief   This is the slot (function) for the finished signal of the proxy thread.
+ */
+void QZmqProxy::onThreadFinished()
+{
+    this->statisticsTimer->stop();
+    emit onFinished(this, this->error);
+}
+
+/**
+ * @brief   Entry point of the proxy thread.
+ */
+void QZmqProxy::run()
+{
+    int rc = zmq_proxy_steerable(this->frontend, this->backend, this->capture, this->control);
+    this->error = rc == 0 ? 0 : QZmqError::getLastError();
+    closeSockets();
+}
+
+/**
+ * @brief   Close the sockets used by the proxy thread.
+ */
+void QZmqProxy::closeSockets()
+{
+    void **sockets[] = {&this->frontend, &this->backend, &this->capture, &this->control};
+    for (void **socket : sockets) {
+        if (*socket != NULL) {
+            zmq_close(*socket);
+            *socket = NULL;
+        }
+    }
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,101 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_PROXY_H__
+#define __QZMQ_PROXY_H__
+
+#include "qzmqcommon.hpp"
+#include <QObject>
+#include <QMetaType>
+
+class QTimer;
+
+QZMQ_BEGIN_NAMESPACE
+
+// Counters reported by zmq_proxy_steerable() for the STATISTICS command.
+struct QZmqProxyStatistics
+{
+    quint64 frontendMessagesIn;
+    quint64 frontendBytesIn;
+    quint64 frontendMessagesOut;
+    quint64 frontendBytesOut;
+    quint64 backendMessagesIn;
+    quint64 backendBytesIn;
+    quint64 backendMessagesOut;
+    quint64 backendBytesOut;
+};
+
+class QZmqSocket;
+class QZmqMultipartMessage;
+class QZmqProxyThread;
+class QZMQ_API QZmqProxy : public QObject
+{
+    Q_OBJECT
+public:
+    static QZmqProxy* create(int frontendType, int backendType, QObject *parent=nullptr);
+    virtual ~QZmqProxy();
+    bool bindFrontend(const char *address);
+    bool connectFrontend(const char *address);
+    bool bindBackend(const char *address);
+    bool connectBackend(const char *address);
+    bool setCapture(const char *address);
+    void* frontendSocket();
+    void* backendSocket();
+    bool start();
+    bool isRunning();
+    void wait();
+    int statisticsInterval();
+    void setStatisticsInterval(int msec);
+
+public slots:
+    void pause();
+    void resume();
+    void terminate();
+    void requestStatistics();
+
+signals:
+    void onStatistics(QZmqProxy *proxy, const QZmqProxyStatistics &stats);
+    void onFinished(QZmqProxy *proxy, int error);
+
+protected slots:
+    void onControlMessage(QZmqSocket *socket, QZmqMultipartMessage *msg);
+    void onThreadFinished();
+
+protected:
+    friend class QZmqProxyThread;
+    QZmqProxy(QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqProxy);
+    void sendCommand(const char *command);
+    void run();
+    void closeSockets();
+
+    void *frontend;
+    void *backend;
+    void *capture;
+    void *control;
+    QZmqSocket *command;
+    QZmqProxyThread *thread;
+    QTimer *statisticsTimer;
+    int error;
+};
+
+QZMQ_END_NAMESPACE
+
+#ifdef QZMQ_NAMESPACE
+Q_DECLARE_METATYPE(QZMQ_NAMESPACE::QZmqProxyStatistics)
+#else
+Q_DECLARE_METATYPE(QZmqProxyStatistics)
+#endif
+
+#endif // __QZMQ_PROXY_H__
@@ -0,0 +1,371 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqreactor.hpp"
+#include "qzmqsocket.hpp"
+#ifdef Q_OS_LINUX
+#include "qzmqeventdispatcher.hpp"
+#endif
+#include <QAbstractEventDispatcher>
+#include <QThreadStorage>
+#include <QTimer>
+
+QZMQ_BEGIN_NAMESPACE
+
+/**
+ * @brief   Construct a new QZmqReactor::QZmqReactor object.
+ *          The reactor hooks into the event dispatcher of the calling thread.
+ *
+ * @param parent Parent object of the reactor.
+ */
+QZmqReactor::QZmqReactor(QObject *parent) : QObject(parent)
+{
+#ifdef ZMQ_HAVE_POLLER
+    this->poller = zmq_poller_new();
+    Q_ASSERT(this->poller != NULL);
+#endif
+    this->dispatcher = NULL;
+    this->dispatching = false;
+    this->polled = false;
+
+    this->wakeUpTimer = new QTimer(this);
+    this->wakeUpTimer->setSingleShot(true);
+    QObject::connect(this->wakeUpTimer, &QTimer::timeout, this, &QZmqReactor::onWakeUpTimer);
+
+    auto dispatcher = QAbstractEventDispatcher::instance(nullptr);
+    Q_ASSERT(dispatcher != NULL);
+    QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &QZmqReactor::onAboutToBlock);
+    QObject::connect(dispatcher, &QAbstractEventDispatcher::awake, this, &QZmqReactor::onAwake);
+
+#ifdef Q_OS_LINUX
+    // A ØMQ aware dispatcher polls the reactor itself before blocking.
+    // So, there is no need for wake-up timers.
+    this->dispatcher = qobject_cast<QZmqEventDispatcher*>(dispatcher);
+    if (this->dispatcher != NULL) {
+        this->dispatcher->setReactor(this);
+    }
+#endif
+}
+
+/**
+ * @brief   Destroy the QZmqReactor::QZmqReactor object.
+ *          Sockets that are still registered are detached from the reactor.
+ */
+QZmqReactor::~QZmqReactor()
+{
+    for (QZmqSocket *socket : this->sockets) {
+        socket->reactor = NULL;
+        socket->reactorIndex = -1;
+    }
+    this->sockets.clear();
+
+#ifdef Q_OS_LINUX
+    if (this->dispatcher != NULL) {
+        this->dispatcher->setReactor(NULL);
+        this->dispatcher = NULL;
+    }
+#endif
+
+#ifdef ZMQ_HAVE_POLLER
+    if (this->poller != NULL) {
+        int rc = zmq_poller_destroy(&this->poller);
+        Q_ASSERT(rc == 0);
+        this->poller = NULL;
+    }
+#endif
+}
+
+/**
+ * @brief   Returns the reactor of the calling thread.
+ *          The reactor is created on first use and destroyed when the thread exits.
+ *
+ * @return QZmqReactor*  A pointer to the reactor of the calling thread.
+ */
+QZmqReactor* QZmqReactor::instance()
+{
+    // Like ØMQ sockets, the reactor is not thread safe.
+    // Every thread that owns sockets gets its own reactor which is driven
+    // by the event dispatcher of that thread.
+    static QThreadStorage<QZmqReactor*> reactors;
+    if (!reactors.hasLocalData()) {
+        reactors.setLocalData(new QZmqReactor());
+    }
+    return reactors.localData();
+}
+
+/**
+ * @brief   Register a socket with the reactor.
+ *          The socket is polled for incoming messages from now on.
+ *
+ * @param socket    A pointer to the socket to be registered.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqReactor::registerSocket(QZmqSocket *socket)
+{
+    Q_ASSERT(socket != NULL);
+    Q_ASSERT(socket->reactor == NULL);
+
+#ifdef ZMQ_HAVE_POLLER
+    int rc = zmq_poller_add(this->poller, socket->socket, socket, ZMQ_POLLIN);
+    if (rc != 0) {
+        return false;
+    }
+    this->pollerEvents.resize(this->sockets.size() + 1);
+#else
+    zmq_pollitem_t item;
+    item.socket = socket->socket;
+    item.fd = 0;
+    item.events = ZMQ_POLLIN;
+    item.revents = 0;
+    this->items.append(item);
+#endif
+
+    socket->reactor = this;
+    socket->reactorIndex = this->sockets.size();
+    this->sockets.append(socket);
+    return true;
+}
+
+/**
+ * @brief   Unregister a socket from the reactor.
+ *          This is done by the socket itself when it is destroyed.
+ *
+ * @param socket    A pointer to the socket to be unregistered.
+ */
+void QZmqReactor::unregisterSocket(QZmqSocket *socket)
+{
+    Q_ASSERT(socket != NULL);
+    if (socket->reactor != this) {
+        return;
+    }
+
+    int index = socket->reactorIndex;
+    Q_ASSERT(index >= 0 && index < this->sockets.size());
+
+#ifdef ZMQ_HAVE_POLLER
+    int rc = zmq_poller_remove(this->poller, socket->socket);
+    Q_ASSERT(rc == 0);
+    this->pollerEvents.resize(this->sockets.size() - 1);
+#else
+    this->items[index] = this->items.last();
+    this->items.removeLast();
+#endif
+
+    // Fill the gap with the last socket so removal stays O(1).
+    QZmqSocket *last = this->sockets.last();
+    this->sockets[index] = last;
+    last->reactorIndex = index;
+    this->sockets.removeLast();
+
+    socket->reactor = NULL;
+    socket->reactorIndex = -1;
+
+    if (this->dispatching || this->polled) {
+        // The socket may be destroyed from within a signal emitted while
+        // dispatching or before the result of the last poll is dispatched.
+        // Make sure that it is not touched later.
+        for (int i = 0; i < this->readySockets.size(); i++) {
+            if (this->readySockets[i] == socket) {
+                this->readySockets[i] = NULL;
+            }
+        }
+    }
+}
+
+/**
+ * @brief   Set the events to be polled for the given socket.
+ *
+ * @param socket    A pointer to a registered socket.
+ * @param events    A combination of ZMQ_POLLIN and ZMQ_POLLOUT.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqReactor::setSocketEvents(QZmqSocket *socket, short events)
+{
+    Q_ASSERT(socket != NULL);
+    Q_ASSERT(socket->reactor == this);
+
+#ifdef ZMQ_HAVE_POLLER
+    int rc = zmq_poller_modify(this->poller, socket->socket, events);
+    return rc == 0;
+#else
+    this->items[socket->reactorIndex].events = events;
+    return true;
+#endif
+}
+
+/**
+ * @brief   Returns the number of sockets registered with the reactor.
+ *
+ * @return int  Number of registered sockets.
+ */
+int QZmqReactor::socketCount()
+{
+    return this->sockets.size();
+}
+
+/**
+ * @brief   Returns the sum of the counters of all sockets registered with the reactor,
+ *          i.e. the counters of the thread. @sa QZmqSocket::stats()
+ * 
+ * @return QZmqSocketStats  Counters of the thread.
+ */
+QZmqSocketStats QZmqReactor::stats()
+{
+    QZmqSocketStats stats = QZmqSocketStats();
+    for (QZmqSocket *socket : this->sockets) {
+        if (socket->metrics != NULL) {
+            socket->metrics->addTo(stats);
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief   Poll all registered sockets in one call and collect the ready ones.
+ *          Both zmq_poll() and the poller of the draft API check the events of every
+ *          registered socket, so the cost grows with the number of sockets.
+ *
+ * @param timeout   Refer to the documentation of zmq_poll().
+ * @return int      Number of sockets that are ready.
+ */
+int QZmqReactor::poll(long timeout)
+{
+    this->readySockets.clear();
+    this->readyEvents.clear();
+
+    if (this->sockets.isEmpty()) {
+        return 0;
+    }
+
+#ifdef ZMQ_HAVE_POLLER
+    int rc = zmq_poller_wait_all(this->poller, this->pollerEvents.data(), this->pollerEvents.size(), timeout);
+    if (rc <= 0) {
+        // EAGAIN is reported when no socket is ready within the timeout.
+        return 0;
+    }
+    for (int i = 0; i < rc; i++) {
+        this->readySockets.append(static_cast<QZmqSocket*>(this->pollerEvents[i].user_data));
+        this->readyEvents.append(this->pollerEvents[i].events);
+    }
+#else
+    int rc = zmq_poll(this->items.data(), this->items.size(), timeout);
+    if (rc <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < this->items.size() && this->readySockets.size() < rc; i++) {
+        if (this->items[i].revents != 0) {
+            this->readySockets.append(this->sockets[i]);
+            this->readyEvents.append(this->items[i].revents);
+        }
+    }
+#endif
+
+    return this->readySockets.size();
+}
+
+/**
+ * @brief   See if any of the registered sockets has pending events.
+ *          The result is kept for the next call of QZmqReactor::processEvents(), so the
+ *          sockets are polled only once per iteration of the event loop.
+ *
+ * @return true     If at least one socket is ready.
+ * @return false    If none of the sockets are ready.
+ */
+bool QZmqReactor::hasPendingEvents()
+{
+    if (this->dispatching) {
+        return false;
+    }
+    this->polled = true;
+    return poll(0) > 0;
+}
+
+/**
+ * @brief   Dispatch the events to the sockets that are ready.
+ *          The result of the last QZmqReactor::hasPendingEvents() call is used if there is
+ *          one. Otherwise, all registered sockets are polled.
+ *          Events that occur in between are reported by the file descriptors of the sockets.
+ */
+void QZmqReactor::processEvents()
+{
+    if (this->dispatching) {
+        // Signal handlers may spin a nested event loop.
+        return;
+    }
+
+    bool polled = this->polled;
+    this->polled = false;
+    if (!polled) {
+        poll(0);
+    }
+    if (this->readySockets.isEmpty()) {
+        return;
+    }
+
+    this->dispatching = true;
+    for (int i = 0; i < this->readySockets.size(); i++) {
+        QZmqSocket *socket = this->readySockets[i];
+        if (socket != NULL) {
+            socket->processEvents(this->readyEvents[i]);
+        }
+    }
+    this->dispatching = false;
+}
+
+/**
+ * @brief   This is the slot (function) for the signal that is emitted just before the
+ *          event dispatcher is blocked. No messages are read in this function.
+ */
+void QZmqReactor::onAboutToBlock()
+{
+    if (this->dispatcher != NULL) {
+        // QZmqEventDispatcher checks for pending events before blocking.
+        return;
+    }
+
+    if (hasPendingEvents()) {
+        // There is activity in at least one socket.
+        // Schedule a single shot timer just to wakeup the event dispatcher.
+        this->wakeUpTimer->start(0);
+    }
+}
+
+/**
+ * @brief   This is the slot (function) for the signal that is emitted just after the
+ *          event dispatcher is awaken. Events are dispatched to the ready sockets.
+ */
+void QZmqReactor::onAwake()
+{
+    if (this->dispatcher != NULL) {
+        // QZmqEventDispatcher dispatches the events right after waking up.
+        return;
+    }
+
+    processEvents();
+}
+
+/**
+ * @brief   This is just a dummy handler for the event loop wake-up timer.
+ *
+ */
+void QZmqReactor::onWakeUpTimer()
+{
+    // Nothing to be done here.
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,72 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_REACTOR_H__
+#define __QZMQ_REACTOR_H__
+
+#include "qzmqcommon.hpp"
+#include "qzmqsocketmetrics.hpp"
+#include <zmq.h>
+#include <QObject>
+#include <QVector>
+
+class QTimer;
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqSocket;
+class QZmqEventDispatcher;
+class QZMQ_API QZmqReactor : public QObject
+{
+    Q_OBJECT
+public:
+    static QZmqReactor* instance();
+    virtual ~QZmqReactor();
+    bool registerSocket(QZmqSocket *socket);
+    void unregisterSocket(QZmqSocket *socket);
+    bool setSocketEvents(QZmqSocket *socket, short events);
+    int socketCount();
+    QZmqSocketStats stats();
+    bool hasPendingEvents();
+    void processEvents();
+
+protected slots:
+    void onAboutToBlock();
+    void onAwake();
+    void onWakeUpTimer();
+
+protected:
+    friend class QZmqEventDispatcher;
+    QZmqReactor(QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqReactor);
+    int poll(long timeout);
+
+    QVector<QZmqSocket*> sockets;
+    QVector<QZmqSocket*> readySockets;
+    QVector<short> readyEvents;
+#ifdef ZMQ_HAVE_POLLER
+    void *poller;
+    QVector<zmq_poller_event_t> pollerEvents;
+#else
+    QVector<zmq_pollitem_t> items;
+#endif
+    QTimer *wakeUpTimer;
+    QZmqEventDispatcher *dispatcher;
+    bool dispatching;
+    bool polled;            // Ready sockets are not dispatched yet
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_REACTOR_H__
@@ -0,0 +1,347 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqrequester.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqcontext.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqerror.hpp"
+#include <QMetaMethod>
+#include <QTimer>
+#include <QtEndian>
+#include <cerrno>
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr int REQUESTER_WHEEL_SLOTS = 512;
+constexpr int REQUESTER_TIMER_RESOLUTION = 10;
+constexpr int REQUESTER_SEND_QUEUE_LIMIT = 65536;
+
+/**
+ * @brief   Construct a new QZmqRequester::QZmqRequester object.
+ *
+ * @param parent    Parent object of the requester.
+ */
+QZmqRequester::QZmqRequester(QObject *parent) : QObject(parent)
+{
+    this->dealer = NULL;
+    this->nextId = 1;
+    this->wheel.resize(REQUESTER_WHEEL_SLOTS);
+    this->currentTick = 0;
+    this->resolution = REQUESTER_TIMER_RESOLUTION;
+    this->timedCount = 0;
+    this->timer = new QTimer(this);
+    this->timer->setTimerType(Qt::PreciseTimer);
+    this->timer->setInterval(this->resolution);
+    QObject::connect(this->timer, &QTimer::timeout, this, &QZmqRequester::onTick);
+    this->clock.start();
+}
+
+/**
+ * @brief   Destroy the QZmqRequester::QZmqRequester object.
+ *          Outstanding requests are dropped without calling their callbacks.
+ */
+QZmqRequester::~QZmqRequester()
+{
+
+}
+
+/**
+ * @brief   Create a requester that uses the shared context.
+ *
+ * @param parent            Parent object of the requester.
+ * @return QZmqRequester*   The requester or NULL if the socket cannot be created.
+ *                          Use QZmqError::getLastError() to get the error code.
+ */
+QZmqRequester* QZmqRequester::create(QObject *parent)
+{
+    return create(QZmqContext::instance(), parent);
+}
+
+/**
+ * @brief   Create a requester whose DEALER socket belongs to the given context.
+ *
+ * @param context           Context of the socket.
+ * @param parent            Parent object of the requester.
+ * @return QZmqRequester*   The requester or NULL if the socket cannot be created.
+ *                          Use QZmqError::getLastError() to get the error code.
+ */
+QZmqRequester* QZmqRequester::create(QZmqContext *context, QObject *parent)
+{
+    QZmqRequester *requester = new QZmqRequester(parent);
+    requester->dealer = QZmqSocket::create(context, ZMQ_DEALER, requester);
+    if (requester->dealer == NULL) {
+        int error = QZmqError::getLastError();
+        delete requester;
+        errno = error;
+        return NULL;
+    }
+
+    requester->dealer->setMultipartMode(true);
+    requester->dealer->setSendQueueLimits(REQUESTER_SEND_QUEUE_LIMIT);
+    QObject::connect(requester->dealer, &QZmqSocket::onMultipartMessage, requester, &QZmqRequester::onMessage);
+    return requester;
+}
+
+/**
+ * @brief   Connect to a server. Requests are load balanced over all connected servers.
+ *
+ * @param address   Address of the server.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqRequester::connect(const char *address)
+{
+    return this->dealer->connect(address);
+}
+
+/**
+ * @brief   Disconnect from a server.
+ *
+ * @param address   Address of the server.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqRequester::disconnect(const char *address)
+{
+    return this->dealer->disconnect(address);
+}
+
+/**
+ * @brief   Send a request without waiting for the replies of the previous requests.
+ *          The request is queued if it cannot be sent right away.
+ *          If no callback is given, the reply is delivered through QZmqRequester::onReply()
+ *          and the timeout through QZmqRequester::onTimeout().
+ *
+ * @param payload   Frames of the request. On success, the message becomes empty.
+ *                  On failure, the frames of the payload that are not sent are left in the
+ *                  message, which normally is the whole payload.
+ * @param callback  Function to be called with the reply or on timeout.
+ * @param timeout   Timeout in milliseconds. A negative value means no timeout.
+ *                  Timeouts are accurate to the timer resolution.
+ * @return quint64  Correlation id of the request or 0 if the request cannot be sent.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+quint64 QZmqRequester::request(QZmqMultipartMessage &&payload, const Callback &callback, int timeout)
+{
+    quint64 id = this->nextId;
+    quint64 wireId = qToLittleEndian(id);
+    int size = payload.size();
+    payload.prepend(QZmqFrame(&wireId, sizeof(wireId)));
+    payload.prepend(QZmqFrame());
+
+    if (!this->dealer->enqueue(std::move(payload))) {
+        int error = QZmqError::getLastError();
+        // Give the payload back to the caller. Frames that are already sent are removed.
+        if (payload.size() > size) {
+            payload.removeFirst(payload.size() - size);
+        }
+        errno = error;
+        return 0;
+    }
+    this->nextId++;
+
+    Pending request;
+    request.callback = callback;
+    request.deadline = 0;
+    if (timeout >= 0) {
+        if (!this->timer->isActive()) {
+            // Ticks of an idle wheel are not visited.
+            this->currentTick = this->clock.elapsed() / this->resolution;
+            this->timer->start();
+        }
+        quint64 ticks = qMax(1, (timeout + this->resolution - 1) / this->resolution);
+        request.deadline = this->clock.elapsed() / this->resolution + ticks;
+        this->wheel[request.deadline % REQUESTER_WHEEL_SLOTS].append(id);
+        this->timedCount++;
+    }
+    this->pending.insert(id, request);
+    return id;
+}
+
+/**
+ * @brief   Forget an outstanding request. Its callback is not called.
+ *          A reply that arrives later is dropped.
+ *
+ * @param id        Correlation id of the request.
+ * @return true     If the request was outstanding.
+ * @return false    If the request is already completed or timed out.
+ */
+bool QZmqRequester::cancel(quint64 id)
+{
+    auto it = this->pending.find(id);
+    if (it == this->pending.end()) {
+        return false;
+    }
+    if (it->deadline != 0) {
+        this->timedCount--;
+    }
+    this->pending.erase(it);
+    return true;
+}
+
+/**
+ * @brief   Returns the number of outstanding requests.
+ *
+ * @return int  Number of outstanding requests.
+ */
+int QZmqRequester::pendingCount()
+{
+    return this->pending.size();
+}
+
+/**
+ * @brief   Returns the resolution of the request timeouts.
+ *
+ * @return int  Resolution in milliseconds.
+ */
+int QZmqRequester::timerResolution()
+{
+    return this->resolution;
+}
+
+/**
+ * @brief   Set the resolution of the request timeouts. The timer wheel covers
+ *          512 times the resolution per round. Longer timeouts take more rounds.
+ *          This must be set while no requests with timeouts are outstanding.
+ *
+ * @param msecs Resolution in milliseconds.
+ */
+void QZmqRequester::setTimerResolution(int msecs)
+{
+    Q_ASSERT(msecs > 0);
+    Q_ASSERT(this->timedCount == 0);
+
+    this->resolution = msecs;
+    this->timer->setInterval(msecs);
+    this->currentTick = this->clock.elapsed() / msecs;
+}
+
+/**
+ * @brief   Returns the underlying DEALER socket, e.g. to set options or send queue limits.
+ *
+ * @return QZmqSocket*  The DEALER socket.
+ */
+QZmqSocket* QZmqRequester::socket()
+{
+    return this->dealer;
+}
+
+/**
+ * @brief   Match a reply with its request. Replies are [empty][correlation id][payload...].
+ *          Malformed replies and replies of requests that are no longer outstanding are dropped.
+ */
+void QZmqRequester::onMessage(QZmqSocket *socket, QZmqMultipartMessage *msg)
+{
+    Q_UNUSED(socket);
+
+    if (msg->size() < 2 || (*msg)[0].size() != 0 || (*msg)[1].size() != sizeof(quint64)) {
+        delete msg;
+        return;
+    }
+    msg->takeFirst();
+    QZmqFrame idFrame = msg->takeFirst();
+    quint64 id = qFromLittleEndian<quint64>(idFrame.data());
+
+    auto it = this->pending.find(id);
+    if (it == this->pending.end()) {
+        delete msg;
+        return;
+    }
+    Callback callback = std::move(it->callback);
+    if (it->deadline != 0) {
+        this->timedCount--;
+    }
+    this->pending.erase(it);
+
+    if (callback) {
+        callback(id, 0, msg);
+        delete msg;
+        return;
+    }
+
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqRequester::onReply);
+    if (QObject::isSignalConnected(signal)) {
+        emit onReply(this, id, msg);
+    } else {
+        delete msg;
+    }
+}
+
+/**
+ * @brief   Visit the slots of the timer wheel that have passed since the last tick.
+ */
+void QZmqRequester::onTick()
+{
+    quint64 now = this->clock.elapsed() / this->resolution;
+    while (this->currentTick < now && this->timedCount > 0) {
+        this->currentTick++;
+        expire(this->currentTick);
+    }
+    if (this->timedCount == 0) {
+        this->timer->stop();
+    }
+}
+
+/**
+ * @brief   Time out the requests whose deadline is the given tick.
+ *          Callbacks are called after the slot is updated, so they can send new requests.
+ *
+ * @param tick  Tick of the timer wheel.
+ */
+void QZmqRequester::expire(quint64 tick)
+{
+    // Callbacks may spin a nested event loop that expires requests itself.
+    // So, the expired requests are kept on the stack.
+    QVector<quint64> expired;
+    QVector<quint64> &slot = this->wheel[tick % REQUESTER_WHEEL_SLOTS];
+    int kept = 0;
+    for (int i = 0; i < slot.size(); i++) {
+        quint64 id = slot[i];
+        auto it = this->pending.constFind(id);
+        if (it == this->pending.constEnd()) {
+            continue;
+        }
+        if (it->deadline <= tick) {
+            expired.append(id);
+        } else {
+            slot[kept++] = id;
+        }
+    }
+    slot.resize(kept);
+
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqRequester::onTimeout);
+    for (int i = 0; i < expired.size(); i++) {
+        quint64 id = expired[i];
+        auto it = this->pending.find(id);
+        if (it == this->pending.end()) {
+            // Cancelled by a callback of another request.
+            continue;
+        }
+        Callback callback = std::move(it->callback);
+        this->timedCount--;
+        this->pending.erase(it);
+
+        if (callback) {
+            callback(id, ETIMEDOUT, NULL);
+        } else if (QObject::isSignalConnected(signal)) {
+            emit onTimeout(this, id);
+        }
+    }
+}
+
+QZMQ_END_NAMESPACE
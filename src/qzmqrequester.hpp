@@ -0,0 +1,93 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_REQUESTER_H__
+#define __QZMQ_REQUESTER_H__
+
+#include "qzmqcommon.hpp"
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <functional>
+
+class QTimer;
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqSocket;
+class QZmqContext;
+class QZmqMultipartMessage;
+
+// Asynchronous request/reply client on a DEALER socket. Any number of requests can be
+// outstanding. Requests are sent as [empty][correlation id][payload...] and the peer,
+// e.g. a ROUTER or a REP socket, has to send the correlation id back in front of the reply.
+class QZMQ_API QZmqRequester : public QObject
+{
+    Q_OBJECT
+public:
+    // Called with error 0 and the reply, or with ETIMEDOUT and NULL reply.
+    // The reply is deleted once the callback returns.
+    typedef std::function<void(quint64 id, int error, QZmqMultipartMessage *reply)> Callback;
+
+    static QZmqRequester* create(QObject *parent=nullptr);
+    static QZmqRequester* create(QZmqContext *context, QObject *parent=nullptr);
+    virtual ~QZmqRequester();
+    bool connect(const char *address);
+    bool disconnect(const char *address);
+    quint64 request(QZmqMultipartMessage &&payload, const Callback &callback=Callback(), int timeout=-1);
+    bool cancel(quint64 id);
+    int pendingCount();
+    int timerResolution();
+    void setTimerResolution(int msecs);
+    QZmqSocket* socket();
+
+signals:
+    // Emitted for requests that are sent without a callback.
+    void onReply(QZmqRequester *requester, quint64 id, QZmqMultipartMessage *reply);
+    void onTimeout(QZmqRequester *requester, quint64 id);
+
+protected slots:
+    void onMessage(QZmqSocket *socket, QZmqMultipartMessage *msg);
+    void onTick();
+
+protected:
+    QZmqRequester(QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqRequester);
+    void expire(quint64 tick);
+
+    struct Pending
+    {
+        Callback callback;
+        quint64 deadline;       // Tick of the timer wheel, 0 if the request has no timeout
+    };
+
+    QZmqSocket *dealer;
+    QHash<quint64, Pending> pending;
+    quint64 nextId;
+
+    // Hashed timer wheel. A slot holds the ids of the requests whose deadline falls on
+    // that slot in the current or in one of the next rounds of the wheel. Ids of requests
+    // that are already completed are dropped when their slot is visited.
+    QVector<QVector<quint64>> wheel;
+    QTimer *timer;
+    QElapsedTimer clock;
+    quint64 currentTick;
+    int resolution;
+    int timedCount;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_REQUESTER_H__
@@ -0,0 +1,270 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqsender.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqerror.hpp"
+#include "qzmqcoalescer.hpp"
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+QZMQ_BEGIN_NAMESPACE
+
+/**
+ * @brief   Construct a new QZmqSender::QZmqSender object.
+ *          Use QZmqSocket::createSender() to create senders.
+ * 
+ * @param socket    The socket that sends the pushed messages.
+ * @param capacity  Maximum number of pending messages. Rounded up to a power of two.
+ */
+QZmqSender::QZmqSender(QZmqSocket *socket, int capacity) : QObject(socket)
+{
+    quintptr size = 2;
+    while (size < static_cast<quintptr>(capacity)) {
+        size <<= 1;
+    }
+
+    this->socket = socket;
+    this->cells = new Cell[size];
+    this->mask = size - 1;
+    for (quintptr i = 0; i < size; i++) {
+        this->cells[i].sequence.storeRelaxed(i);
+    }
+    this->enqueuePos.storeRelaxed(0);
+    this->dequeuePos = 0;
+    this->wakeUpPending.storeRelaxed(0);
+    this->eventFd = -1;
+    this->notifier = NULL;
+
+#ifdef Q_OS_LINUX
+    this->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Q_ASSERT(this->eventFd >= 0);
+    this->notifier = new QSocketNotifier(this->eventFd, QSocketNotifier::Read, this);
+    QObject::connect(this->notifier, &QSocketNotifier::activated, this, &QZmqSender::onWakeUp);
+    this->notifier->setEnabled(true);
+#endif
+}
+
+/**
+ * @brief   Destroy the QZmqSender::QZmqSender object.
+ *          Messages that are not sent yet are discarded.
+ */
+QZmqSender::~QZmqSender()
+{
+    this->socket->senders.removeOne(this);
+
+    if (this->notifier != NULL) {
+        this->notifier->setEnabled(false);
+        delete this->notifier;
+        this->notifier = NULL;
+    }
+
+#ifdef Q_OS_LINUX
+    if (this->eventFd >= 0) {
+        close(this->eventFd);
+        this->eventFd = -1;
+    }
+#endif
+
+    while (this->cells[this->dequeuePos & this->mask].sequence.loadAcquire() == this->dequeuePos + 1) {
+        zmq_msg_close(&this->cells[this->dequeuePos & this->mask].msg);
+        this->dequeuePos++;
+    }
+    delete[] this->cells;
+    this->cells = NULL;
+}
+
+/**
+ * @brief   Push a frame to be sent by the socket. This function can be called from any thread.
+ *          On success, the content of the frame is handed over and the frame becomes empty.
+ *          On failure, the frame is left untouched.
+ *          Multipart messages are not supported since frames of different threads would
+ *          be interleaved.
+ * 
+ * @param frame The frame to be sent.
+ * @return true     If the frame is queued.
+ * @return false    If the sender is full. The error code is set to EAGAIN.
+ */
+bool QZmqSender::send(QZmqFrame &&frame)
+{
+    return push(frame.zmqMsg());
+}
+
+/**
+ * @brief   Push a copy of the given data to be sent by the socket.
+ *          This function can be called from any thread.
+ * 
+ * @param data  A pointer to the data to be copied.
+ * @param size  Size of the data in bytes.
+ * @return true     If the data is queued.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSender::send(const void *data, size_t size)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init_size(&msg, size);
+    if (rc != 0) {
+        return false;
+    }
+    memcpy(zmq_msg_data(&msg), data, size);
+
+    if (!push(&msg)) {
+        zmq_msg_close(&msg);
+        errno = EAGAIN;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Returns the maximum number of pending messages.
+ * 
+ * @return int  Capacity of the sender.
+ */
+int QZmqSender::capacity()
+{
+    return static_cast<int>(this->mask + 1);
+}
+
+/**
+ * @brief   Move a message into a free cell and wake up the thread of the socket.
+ * 
+ * @param msg   The message to be moved. It becomes empty on success.
+ * @return true     If the message is queued.
+ * @return false    If there are no free cells.
+ */
+bool QZmqSender::push(zmq_msg_t *msg)
+{
+    // Bounded MPSC queue. Each cell carries a sequence number that tells producers
+    // and the consumer whether the cell is free or holds a message for them.
+    Cell *cell;
+    quintptr pos = this->enqueuePos.loadRelaxed();
+    for (;;) {
+        cell = &this->cells[pos & this->mask];
+        quintptr seq = cell->sequence.loadAcquire();
+        qintptr diff = static_cast<qintptr>(seq) - static_cast<qintptr>(pos);
+        if (diff == 0) {
+            if (this->enqueuePos.testAndSetRelaxed(pos, pos + 1, pos)) {
+                break;
+            }
+        } else if (diff < 0) {
+            errno = EAGAIN;
+            return false;
+        } else {
+            pos = this->enqueuePos.loadRelaxed();
+        }
+    }
+
+    zmq_msg_init(&cell->msg);
+    zmq_msg_move(&cell->msg, msg);
+    cell->sequence.storeRelease(pos + 1);
+
+    wakeUp();
+    return true;
+}
+
+/**
+ * @brief   Wake up the thread of the socket unless a wake-up is already pending.
+ *          So, a burst of messages costs a single system call.
+ */
+void QZmqSender::wakeUp()
+{
+    if (!this->wakeUpPending.testAndSetOrdered(0, 1)) {
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    eventfd_write(this->eventFd, 1);
+#else
+    QMetaObject::invokeMethod(this, "onWakeUp", Qt::QueuedConnection);
+#endif
+}
+
+/**
+ * @brief   This is the slot (function) that is called in the thread of the socket when
+ *          new messages are pushed.
+ */
+void QZmqSender::onWakeUp()
+{
+#ifdef Q_OS_LINUX
+    eventfd_t value;
+    eventfd_read(this->eventFd, &value);
+#endif
+
+    // Clear the flag before draining so that messages pushed from now on wake us up again.
+    this->wakeUpPending.fetchAndStoreOrdered(0);
+    flush();
+}
+
+/**
+ * @brief   Check if there are no pushed messages left to be sent.
+ *          This function must be called from the thread of the socket.
+ */
+bool QZmqSender::isEmpty()
+{
+    return this->cells[this->dequeuePos & this->mask].sequence.loadAcquire() != this->dequeuePos + 1;
+}
+
+/**
+ * @brief   Send the pushed messages through the socket.
+ *          Sending is paused if the socket cannot accept more messages and resumed
+ *          when the socket is ready to send again. Messages that were queued in the socket
+ *          or a sealed batch of coalescing mode go first, so nothing is sent while there
+ *          are such messages. QZmqSocket::readyToSend() calls this function again once
+ *          they are sent.
+ * 
+ * @return true     If all pushed messages are sent.
+ * @return false    If there are messages left.
+ */
+bool QZmqSender::flush()
+{
+    if (!this->socket->sendQueue.empty() ||
+        (this->socket->coalescer != NULL && this->socket->coalescer->isSealed())) {
+        this->socket->setWriteInterest(true);
+        return isEmpty();
+    }
+
+    // Do not starve the event loop if producers keep pushing.
+    quintptr limit = this->mask + 1;
+    for (quintptr i = 0; i < limit; i++) {
+        Cell *cell = &this->cells[this->dequeuePos & this->mask];
+        if (cell->sequence.loadAcquire() != this->dequeuePos + 1) {
+            return true;
+        }
+
+        if (!this->socket->sendMsg(&cell->msg, ZMQ_DONTWAIT)) {
+            int error = QZmqError::getLastError();
+            if (error == EAGAIN) {
+                return false;
+            }
+            emit this->socket->onError(this->socket, error);
+        }
+
+        zmq_msg_close(&cell->msg);
+        cell->sequence.storeRelease(this->dequeuePos + this->mask + 1);
+        this->dequeuePos++;
+    }
+
+    wakeUp();
+    return false;
+}
+
+QZMQ_END_NAMESPACE
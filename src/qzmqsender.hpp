@@ -0,0 +1,71 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_SENDER_H__
+#define __QZMQ_SENDER_H__
+
+#include "qzmqcommon.hpp"
+#include <zmq.h>
+#include <QObject>
+#include <QAtomicInteger>
+
+class QSocketNotifier;
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqSocket;
+class QZmqFrame;
+class QZMQ_API QZmqSender : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~QZmqSender();
+    bool send(QZmqFrame &&frame);
+    bool send(const void *data, size_t size);
+    int capacity();
+
+protected slots:
+    void onWakeUp();
+
+protected:
+    friend class QZmqSocket;
+    QZmqSender(QZmqSocket *socket, int capacity);
+    Q_DISABLE_COPY(QZmqSender);
+    bool push(zmq_msg_t *msg);
+    void wakeUp();
+    bool isEmpty();
+    bool flush();
+
+    struct Cell
+    {
+        QAtomicInteger<quintptr> sequence;
+        zmq_msg_t msg;
+    };
+
+    QZmqSocket *socket;
+    Cell *cells;
+    quintptr mask;
+    // Keep the producer and the consumer positions on separate cache lines.
+    char padding0[64];
+    QAtomicInteger<quintptr> enqueuePos;
+    char padding1[64];
+    quintptr dequeuePos;
+    QAtomicInt wakeUpPending;
+    int eventFd;
+    QSocketNotifier *notifier;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_SENDER_H__
@@ -14,16 +14,40 @@
 
 #include "qzmqsocket.hpp"
 #include "qzmqmessage.hpp"
+#include "qzmqmessagepool.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqsender.hpp"
+#include "qzmqmonitor.hpp"
 #include "qzmqcontext.hpp"
 #include "qzmqerror.hpp"
+#include "qzmqreactor.hpp"
+#include "qzmqcompressor.hpp"
+#include "qzmqcoalescer.hpp"
 #include <QSocketNotifier>
 #include <QMetaMethod>
-#include <QAbstractEventDispatcher>
+#include <QElapsedTimer>
 #include <QTimer>
+#include <QtEndian>
+#include <cerrno>
+#include <cstring>
 
 QZMQ_BEGIN_NAMESPACE
 
 constexpr int DEFAULT_MAX_THROUGHPUT = 1000;
+constexpr int DEFAULT_SEND_QUEUE_MESSAGES = 1000;
+constexpr int DEFAULT_COALESCE_MESSAGES = 256;
+constexpr int DEFAULT_COALESCE_BYTES = 16384;
+constexpr int DEFAULT_COALESCE_DELAY = 100;
+
+// Metrics are compiled out entirely without QZMQ_WITH_METRICS.
+#ifdef QZMQ_WITH_METRICS
+#define QZMQ_METRICS(statement) this->metrics->statement
+#define QZMQ_TIME_HANDLER() QZmqHandlerTimer handlerTimer(this->metrics)
+#else
+#define QZMQ_METRICS(statement)
+#define QZMQ_TIME_HANDLER()
+#endif
 
 /**
  * @brief   Construct a new QZmqSocket::QZmqSocket object
@@ -33,10 +57,36 @@ constexpr int DEFAULT_MAX_THROUGHPUT = 1000;
 QZmqSocket::QZmqSocket(QObject* parent) : QObject(parent)
 {
     this->socket = NULL;
+    this->fdPoller = NULL;
+    this->context = NULL;
+    this->socketMonitor = NULL;
+#ifdef QZMQ_WITH_METRICS
+    this->metrics = new QZmqSocketMetrics();
+#else
+    this->metrics = NULL;
+#endif
     this->readNotifier = NULL;
     this->writeNotifier = NULL;
-    this->wakeUpTimer = NULL;
+    this->writeInterest = false;
+    this->readPaused = false;
+    this->reactor = NULL;
+    this->reactorIndex = -1;
     this->maxThroughput = DEFAULT_MAX_THROUGHPUT;
+    this->batchEnabled = false;
+    this->multipartEnabled = false;
+    this->partial = NULL;
+    this->pool = NULL;
+    this->frameCompressor = NULL;
+    this->coalescer = NULL;
+    this->coalesceTimer = NULL;
+    this->coalesceMessages = DEFAULT_COALESCE_MESSAGES;
+    this->coalesceBytes = DEFAULT_COALESCE_BYTES;
+    this->coalesceDelay = DEFAULT_COALESCE_DELAY;
+    this->sendQueueMaxMessages = DEFAULT_SEND_QUEUE_MESSAGES;
+    this->sendQueueMaxBytes = 0;
+    this->sendQueueMessages = 0;
+    this->sendQueueSizeBytes = 0;
+    this->sendQueueHighWater = false;
 }
 
 /**
@@ -45,9 +95,23 @@ QZmqSocket::QZmqSocket(QObject* parent) : QObject(parent)
  */
 QZmqSocket::~QZmqSocket()
 {
-    if (this->wakeUpTimer != NULL) {
-        delete this->wakeUpTimer;
-        this->wakeUpTimer = NULL;
+    // The messages of the current batch were reported as sent. Give them a last chance
+    // and report them as dropped if they still cannot be sent.
+    if (this->coalescer != NULL && !flushCoalesced() && !this->coalescer->isEmpty()) {
+        int count = this->coalescer->pendingMessages();
+        QZMQ_METRICS(coalescedDropped(count));
+        emit onCoalescedDropped(this, count);
+    }
+
+    disableMonitor();
+
+    // Senders remove themselves from the socket.
+    while (!this->senders.isEmpty()) {
+        delete this->senders.last();
+    }
+
+    if (this->reactor != NULL) {
+        this->reactor->unregisterSocket(this);
     }
 
     if (this->readNotifier != NULL) {
@@ -62,15 +126,49 @@ QZmqSocket::~QZmqSocket()
         this->writeNotifier = NULL;            
     }
 
+    if (this->partial != NULL) {
+        delete this->partial;
+        this->partial = NULL;
+    }
+
+    if (this->coalescer != NULL) {
+        delete this->coalescer;
+        this->coalescer = NULL;
+    }
+
+    if (this->coalesceTimer != NULL) {
+        this->coalesceTimer->stop();
+        delete this->coalesceTimer;
+        this->coalesceTimer = NULL;
+    }
+
+#ifdef ZMQ_BUILD_DRAFT_API
+    if (this->fdPoller != NULL) {
+        int rc = zmq_poller_destroy(&this->fdPoller);
+        Q_ASSERT(rc == 0);
+        this->fdPoller = NULL;
+    }
+#endif
+
     if (this->socket != NULL) {
         int rc = zmq_close(this->socket);
         Q_ASSERT(rc == 0);
         this->socket = NULL;
     }
+
+    if (this->frameCompressor != NULL) {
+        delete this->frameCompressor;
+        this->frameCompressor = NULL;
+    }
+
+    if (this->metrics != NULL) {
+        delete this->metrics;
+        this->metrics = NULL;
+    }
 }
 
 /**
- * @brief   Create 0MQ socket.
+ * @brief   Create 0MQ socket in the shared context. @sa QZmqContext::instance()
  * 
  * @param type      Refer to the documentation of zmq_socket().
  * @param parent    Parent object of the created socket object.
@@ -80,7 +178,23 @@ QZmqSocket::~QZmqSocket()
  */
 QZmqSocket* QZmqSocket::create(int type, QObject* parent)
 {
-    QZmqContext *context = QZmqContext::instance();
+    return create(QZmqContext::instance(), type, parent);
+}
+
+/**
+ * @brief   Create 0MQ socket in the given context.
+ *          The socket must be destroyed before the context.
+ * 
+ * @param context   The context in which the socket is created. @sa QZmqContext::create()
+ * @param type      Refer to the documentation of zmq_socket().
+ * @param parent    Parent object of the created socket object.
+ * @return QZmqSocket*  A pointer to the created socket. 
+ *                      NULL is returned if the socket creation is failed.
+ *                      Use QZmqError::getLastError() to get the error code.
+ */
+QZmqSocket* QZmqSocket::create(QZmqContext *context, int type, QObject* parent)
+{
+    Q_ASSERT(context != NULL);
     void *socket = zmq_socket(context->context, type);
     if (socket == NULL) {
         return NULL;
@@ -88,30 +202,62 @@ QZmqSocket* QZmqSocket::create(int type, QObject* parent)
 
     qintptr fd;
     size_t fd_size = sizeof(fd);
+    void *fdPoller = NULL;
     int rc = zmq_getsockopt(socket, ZMQ_FD, &fd, &fd_size);
     if (rc != 0) {
+#ifdef ZMQ_BUILD_DRAFT_API
+        // Thread safe sockets (CLIENT, SERVER, RADIO, DISH, SCATTER, GATHER, ...) have no ZMQ_FD.
+        // A poller that holds only this socket provides a file descriptor to be watched instead.
+        zmq_fd_t pollerFd;
+        fdPoller = zmq_poller_new();
+        if (fdPoller == NULL ||
+            zmq_poller_add(fdPoller, socket, NULL, ZMQ_POLLIN) != 0 ||
+            zmq_poller_fd(fdPoller, &pollerFd) != 0) {
+            int error = QZmqError::getLastError();
+            if (fdPoller != NULL) {
+                zmq_poller_destroy(&fdPoller);
+            }
+            zmq_close(socket);
+            errno = error;
+            return NULL;
+        }
+        fd = pollerFd;
+#else
+        int error = QZmqError::getLastError();
+        zmq_close(socket);
+        errno = error;
         return NULL;
+#endif
     }
 
+    // Allow delivering batches through queued connections.
+    static int batchTypeId = qRegisterMetaType<QVector<QZmqMessage*> >();
+    Q_UNUSED(batchTypeId);
+    static int multipartTypeId = qRegisterMetaType<QZmqMultipartMessage*>();
+    Q_UNUSED(multipartTypeId);
+
     QZmqSocket* qsocket = new QZmqSocket(parent);
     qsocket->socket = socket;
+    qsocket->context = context;
+    qsocket->fdPoller = fdPoller;
 
     qsocket->readNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, qsocket);
     QObject::connect(qsocket->readNotifier, &QSocketNotifier::activated, qsocket, &QZmqSocket::readActivated);
     qsocket->readNotifier->setEnabled(true);
 
-    qsocket->writeNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, qsocket);
-    QObject::connect(qsocket->writeNotifier, &QSocketNotifier::activated, qsocket, &QZmqSocket::writeActivated);
-    qsocket->writeNotifier->setEnabled(false);
-
-    qsocket->wakeUpTimer = new QTimer(qsocket);
-    qsocket->wakeUpTimer->setSingleShot(true);
-    QObject::connect(qsocket->wakeUpTimer, &QTimer::timeout, qsocket, &QZmqSocket::onWakeUpTimer);
+    // The file descriptor of a poller is an eventfd which is always writable. It becomes
+    // readable for ZMQ_POLLOUT as well, so it is watched only for reading.
+    if (fdPoller == NULL) {
+        qsocket->writeNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, qsocket);
+        QObject::connect(qsocket->writeNotifier, &QSocketNotifier::activated, qsocket, &QZmqSocket::writeActivated);
+        qsocket->writeNotifier->setEnabled(false);
+    }
 
-    auto dispatcher = QAbstractEventDispatcher::instance(nullptr); 
-    Q_ASSERT(dispatcher != NULL);
-    QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, qsocket, &QZmqSocket::onAboutToBlock);
-    QObject::connect(dispatcher, &QAbstractEventDispatcher::awake, qsocket, &QZmqSocket::onAwake);
+    // Edge triggered notifications of the socket are handled by the reactor of this thread.
+    if (!QZmqReactor::instance()->registerSocket(qsocket)) {
+        delete qsocket;
+        return NULL;
+    }
 
     return qsocket;
 }
@@ -123,7 +269,10 @@ QZmqSocket* QZmqSocket::create(int type, QObject* parent)
  */
 void QZmqSocket::readActivated(int socket)
 {
+    clearFdPoller();
     receiveAll();
+    // Both ZMQ_FD and the file descriptor of the poller signal ZMQ_POLLOUT as well.
+    checkReadyToSend();
 }
 
 /**
@@ -133,49 +282,77 @@ void QZmqSocket::readActivated(int socket)
  */
 void QZmqSocket::writeActivated(int socket)
 {
+    clearFdPoller();
     checkReadyToSend();
 }
 
 /**
- * @brief   This is the slot (function) for the signal that is emitted just before the
- *          event dispatcher is blocked. No messages are read in this function.
+ * @brief   Reset the file descriptor of the poller used for thread safe sockets.
+ *          The file descriptor stays readable until the poller is waited on.
  */
-void QZmqSocket::onAboutToBlock()
+void QZmqSocket::clearFdPoller()
 {
-    bool eventPending = false;
-    int events = this->events();
-    if (events & ZMQ_POLLIN) {
-        eventPending = true;
+#ifdef ZMQ_BUILD_DRAFT_API
+    if (this->fdPoller != NULL) {
+        zmq_poller_event_t event;
+        zmq_poller_wait_all(this->fdPoller, &event, 1, 0);
     }
+#endif
+}
 
-    if (this->writeNotifier->isEnabled() && (events & ZMQ_POLLOUT)) {
-        eventPending = true;
+/**
+ * @brief   Handle the events reported by the reactor for this socket.
+ *          Messages are read and ready send signal emitted if needed.
+ *          @sa QZmqReactor::processEvents()
+ * 
+ * @param events    Ready events of the socket (ZMQ_POLLIN and/or ZMQ_POLLOUT).
+ */
+void QZmqSocket::processEvents(int events)
+{
+    if (events & ZMQ_POLLIN) {
+        receiveAll();
     }
 
-    if (eventPending) {
-        // There is activity in the socket. 
-        // Schedule a single shot timer just to wakeup the event dispatcher.
-        this->wakeUpTimer->start(0);
+    if ((events & ZMQ_POLLOUT) && this->writeInterest) {
+        readyToSend();
     }
 }
 
 /**
- * @brief   This is the slot (function) for the signal that is emitted just after the
- *          event dispatcher is awaken. Messages are read and ready send signal emitted if needed.
+ * @brief   Enable or disable notifications about the socket being ready to send.
+ *          The write notifier, the reactor and the poller of thread safe sockets are
+ *          updated only if the state changes.
+ * 
+ * @param enabled   Whether or not to get notified when the socket is ready to send.
  */
-void QZmqSocket::onAwake()
+void QZmqSocket::setWriteInterest(bool enabled)
 {
-    receiveAll();
-    checkReadyToSend();
+    if (this->writeInterest == enabled) {
+        return;
+    }
+
+    this->writeInterest = enabled;
+    if (this->writeNotifier != NULL) {
+        this->writeNotifier->setEnabled(enabled);
+    }
+    updateEvents();
 }
 
 /**
- * @brief   This is just a dummy handler for the event loop wake-up timer.
- * 
+ * @brief   Update the events the reactor and the poller of thread safe sockets watch for,
+ *          i.e. ZMQ_POLLIN unless receiving is paused and ZMQ_POLLOUT if there is write interest.
  */
-void QZmqSocket::onWakeUpTimer()
+void QZmqSocket::updateEvents()
 {
-    // Nothing to be done here.
+    short events = (this->readPaused ? 0 : ZMQ_POLLIN) | (this->writeInterest ? ZMQ_POLLOUT : 0);
+    if (this->reactor != NULL) {
+        this->reactor->setSocketEvents(this, events);
+    }
+#ifdef ZMQ_BUILD_DRAFT_API
+    if (this->fdPoller != NULL) {
+        zmq_poller_modify(this->fdPoller, this->socket, events);
+    }
+#endif
 }
 
 /**
@@ -302,6 +479,49 @@ bool QZmqSocket::disconnect(const char* address)
     return true;
 }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+/**
+ * @brief   Join a group to receive messages sent to the group.
+ *          Only DISH sockets can join groups.
+ *          Refer to the documentation of zmq_join().
+ * 
+ * @param group     Name of the group.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::join(const char *group)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    int rc = zmq_join(this->socket, group);
+    if (rc != 0) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Leave a group.
+ *          Refer to the documentation of zmq_leave().
+ * 
+ * @param group     Name of the group.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::leave(const char *group)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    int rc = zmq_leave(this->socket, group);
+    if (rc != 0) {
+        return false;
+    }
+    return true;
+}
+#endif
+
 /**
  * @brief   Retrieve socket event state.
  *          Operation of this function is similar to QZmqSocket::getOption() with 
@@ -333,37 +553,290 @@ bool QZmqSocket::receive(QZmqMessage *msg, int flags)
     Q_ASSERT(msg != NULL);
     Q_ASSERT(this->socket != NULL);
 
-    int rc = zmq_msg_recv(msg->msg, this->socket, flags);
+    int rc = receiveFrame(msg->msg, flags);
+    if (rc < 0) {
+        QZMQ_METRICS(receiveFailed());
+        return false;
+    }
+    QZMQ_METRICS(received(rc));
+    return true;
+}
+
+/**
+ * @brief   Receive a frame from the socket.
+ *          Any content previously stored in the frame is released.
+ * 
+ * @param frame A reference to the frame that stores the incoming message.
+ *              @sa QZmqFrame.
+ * @param flags Refer to the documentation of zmq_msg_recv().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::receive(QZmqFrame &frame, int flags)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    int rc = receiveFrame(&frame.msg, flags);
     if (rc < 0) {
+        QZMQ_METRICS(receiveFailed());
         return false;
     }
+    QZMQ_METRICS(received(rc));
     return true;
 }
 
 /**
  * @brief   Receive all available messages from the socket and emit onMessage() signal.
+ *          In batch mode, all messages received in one call are emitted at once through
+ *          onMessages() signal instead.
+ *          In multipart mode, complete messages are emitted through onMultipartMessage()
+ *          signal. Multipart mode takes precedence over coalescing mode, which takes
+ *          precedence over batch mode. @sa QZmqSocket::setCoalescingMode()
  *          The maximum number of massages received in one call to this function is limited
  *          by QZmqSocket::maxThroughput.
  *          @sa QZmqSocket::setMaximumThroughput()
+ *          @sa QZmqSocket::setBatchMode()
  */
 void QZmqSocket::receiveAll()
 {
+    if (this->readPaused) {
+        return;
+    }
+
+    if (this->multipartEnabled) {
+        receiveMultipart();
+        return;
+    }
+
+    if (this->coalescer != NULL) {
+        receiveCoalesced();
+        return;
+    }
+
+    if (this->batchEnabled) {
+        receiveBatch();
+        return;
+    }
+
     int i = 0;
     while ((events() & ZMQ_POLLIN) && i < this->maxThroughput) {
-        QZmqMessage *msg = QZmqMessage::create(this);
+        QZmqMessage *msg = createMessage();
         if (receive(msg)) {
             static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqSocket::onMessage);
             if (QObject::isSignalConnected(signal)) {
+                QZMQ_TIME_HANDLER();
                 emit onMessage(this, msg);
             } else {
-                delete msg; 
+                msg->release();
+            }
+        } else {
+            emit onError(this, QZmqError::getLastError());
+            msg->release();
+        }
+        i++;
+    }
+    QZMQ_METRICS(receivePass(i, this->maxThroughput));
+}
+
+/**
+ * @brief   Receive all available messages from the socket and emit them through a single
+ *          onMessages() signal.
+ */
+void QZmqSocket::receiveBatch()
+{
+    // The container is reused between passes to avoid reallocations.
+    this->batch.clear();
+
+    int i = 0;
+    while ((events() & ZMQ_POLLIN) && i < this->maxThroughput) {
+        QZmqMessage *msg = createMessage();
+        if (receive(msg)) {
+            this->batch.append(msg);
+        } else {
+            emit onError(this, QZmqError::getLastError());
+            msg->release();
+        }
+        i++;
+    }
+    QZMQ_METRICS(receivePass(i, this->maxThroughput));
+
+    if (this->batch.isEmpty()) {
+        return;
+    }
+
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqSocket::onMessages);
+    if (QObject::isSignalConnected(signal)) {
+        QZMQ_TIME_HANDLER();
+        emit onMessages(this, this->batch);
+    } else {
+        for (QZmqMessage *msg : this->batch) {
+            msg->release();
+        }
+    }
+    this->batch.clear();
+}
+
+/**
+ * @brief   Receive all available multipart messages from the socket and emit every complete
+ *          message through a single onMultipartMessage() signal.
+ *          The maximum throughput limits the number of complete messages received in one call.
+ */
+void QZmqSocket::receiveMultipart()
+{
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqSocket::onMultipartMessage);
+
+    int i = 0;
+    while (i < this->maxThroughput) {
+        // ØMQ delivers multipart messages atomically. Once the first frame has arrived,
+        // the remaining frames can be read without checking the socket events.
+        if (this->partial == NULL) {
+            if (!(events() & ZMQ_POLLIN)) {
+                break;
+            }
+            this->partial = new QZmqMultipartMessage();
+        }
+
+        bool more = true;
+        while (more) {
+            QZmqFrame &frame = this->partial->append();
+            if (!receive(frame)) {
+                this->partial->removeLast();
+                break;
+            }
+            more = frame.more();
+        }
+
+        if (more) {
+            int error = QZmqError::getLastError();
+            if (error == EAGAIN) {
+                // Keep the received frames until the rest of the message arrives.
+                break;
             }
+            emit onError(this, error);
+            delete this->partial;
+            this->partial = NULL;
         } else {
+            QZmqMultipartMessage *msg = this->partial;
+            this->partial = NULL;
+            if (QObject::isSignalConnected(signal)) {
+                QZMQ_TIME_HANDLER();
+                emit onMultipartMessage(this, msg);
+            } else {
+                delete msg;
+            }
+        }
+        i++;
+    }
+    QZMQ_METRICS(receivePass(i, this->maxThroughput));
+}
+
+/**
+ * @brief   Receive all available batch frames of coalescing mode and emit their messages
+ *          through a single onMessages() signal, or through onMessage() signal one by one if
+ *          onMessages() signal is not connected.
+ *          The maximum throughput limits the number of batch frames received in one call.
+ *          @sa QZmqSocket::setCoalescingMode()
+ */
+void QZmqSocket::receiveCoalesced()
+{
+    this->batch.clear();
+
+    QZmqFrame frame;
+    int i = 0;
+    while ((events() & ZMQ_POLLIN) && i < this->maxThroughput) {
+        if (receiveFrame(frame.zmqMsg(), ZMQ_DONTWAIT) < 0) {
+            QZMQ_METRICS(receiveFailed());
+            emit onError(this, QZmqError::getLastError());
+        } else if (!unpack(frame)) {
             emit onError(this, QZmqError::getLastError());
-            delete msg;
         }
         i++;
     }
+    QZMQ_METRICS(receivePass(i, this->maxThroughput));
+
+    if (this->batch.isEmpty()) {
+        return;
+    }
+
+    static const QMetaMethod batchSignal = QMetaMethod::fromSignal(&QZmqSocket::onMessages);
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqSocket::onMessage);
+    if (QObject::isSignalConnected(batchSignal)) {
+        QZMQ_TIME_HANDLER();
+        emit onMessages(this, this->batch);
+    } else if (QObject::isSignalConnected(signal)) {
+        for (QZmqMessage *msg : this->batch) {
+            QZMQ_TIME_HANDLER();
+            emit onMessage(this, msg);
+        }
+    } else {
+        for (QZmqMessage *msg : this->batch) {
+            msg->release();
+        }
+    }
+    this->batch.clear();
+}
+
+/**
+ * @brief   Split a batch frame into messages and append them to the batch of the socket.
+ *          The content of each message is copied. Messages of up to 33 bytes are stored
+ *          inline by ØMQ, so tiny messages do not need any heap allocation. The messages
+ *          are taken from the message pool of the socket or, if it has none, from the pool
+ *          of the thread (QZmqMessagePool::instance()). Otherwise, each tiny message would
+ *          cost a new QObject and zmq_msg_t.
+ * 
+ * @param frame     The received batch frame.
+ * @return true     If the operation is successful.
+ * @return false    If the frame is malformed (EPROTO) or a message cannot be allocated.
+ *                  Messages before the failed part are kept.
+ */
+bool QZmqSocket::unpack(QZmqFrame &frame)
+{
+    QZMQ_METRICS(coalescedReceived());
+
+    QZmqMessagePool *messages = this->pool != NULL ? this->pool : QZmqMessagePool::instance();
+    const char *data = static_cast<const char*>(frame.data());
+    size_t left = frame.size();
+    while (left > 0) {
+        // Each message is prefixed with its 32-bit length in little endian.
+        if (left < sizeof(quint32)) {
+            errno = EPROTO;
+            return false;
+        }
+        quint32 size = qFromLittleEndian<quint32>(data);
+        data += sizeof(quint32);
+        left -= sizeof(quint32);
+        if (size > left) {
+            errno = EPROTO;
+            return false;
+        }
+
+        QZmqMessage *msg = messages->acquire(size);
+        if (msg == NULL) {
+            return false;
+        }
+        memcpy(zmq_msg_data(msg->msg), data, size);
+        data += size;
+        left -= size;
+        QZMQ_METRICS(received(size));
+        this->batch.append(msg);
+    }
+    return true;
+}
+
+/**
+ * @brief   Create a message for receiving.
+ *          The message is taken from the message pool of the socket if there is one.
+ *          @sa QZmqSocket::setMessagePool()
+ * 
+ * @return QZmqMessage*  A pointer to an empty message.
+ */
+QZmqMessage* QZmqSocket::createMessage()
+{
+    if (this->pool != NULL) {
+        return this->pool->acquire();
+    }
+    return QZmqMessage::create(this);
 }
 
 /**
@@ -382,71 +855,639 @@ void QZmqSocket::receiveAll()
 bool QZmqSocket::send(QZmqMessage *msg, int flags)
 {
     Q_ASSERT(msg != NULL);
-    Q_ASSERT(this->socket != NULL);
-
-    int rc = zmq_msg_send(msg->msg, this->socket, flags);
-    if (rc < 0) {
-        if (QZmqError::getLastError() == EAGAIN) {
-            // Non-blocking mode was requested and the message cannot be sent at the moment.
-            // Enable the write notifier to get notification when the socket is ready to send again.
-            this->writeNotifier->setEnabled(true);
-        }
-        return false;
-    } else {
-        // For the moment, we can still send data over the socket.
-        // So, we do not need to worry about the ready-to-send event.
-        this->writeNotifier->setEnabled(false);
-    }
+    return sendMsg(msg->msg, flags);
+}
 
-    return true;
+/**
+ * @brief   Send a frame through the socket.
+ *          On success, the content of the frame is handed over to ØMQ and the frame becomes empty.
+ *          On failure, the frame is left untouched so that it can be sent again later.
+ *          @sa QZmqSocket::onReadyToSend()
+ * 
+ * @param frame The frame to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::send(QZmqFrame &&frame, int flags)
+{
+    return sendMsg(&frame.msg, flags);
 }
 
 /**
- * @brief   Check if the socket is ready to send massages.
- *          If the socket is ready, QZmqSocket::onReadyToSend() signal will be emitted.
+ * @brief   Send all frames of a multipart message through the socket in one call.
+ *          ZMQ_SNDMORE is set on every frame except the last one.
+ *          On success, the multipart message becomes empty.
+ *          On failure, the frames that are already sent are removed and the frames that
+ *          are not sent yet are left in the message.
+ *          Since ØMQ accepts either all or none of the frames of a message once the first
+ *          frame is accepted, a failure normally leaves the whole message untouched.
+ *          @sa QZmqSocket::onReadyToSend()
+ * 
+ * @param msg   The multipart message to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send(). ZMQ_SNDMORE is set as needed.
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
  */
-void QZmqSocket::checkReadyToSend()
+bool QZmqSocket::send(QZmqMultipartMessage &&msg, int flags)
 {
-    if (this->writeNotifier->isEnabled()) {
-        if (events() & ZMQ_POLLOUT) {
-            this->writeNotifier->setEnabled(false);
-            emit onReadyToSend(this);
+    Q_ASSERT(!msg.isEmpty());
+
+    int last = msg.size() - 1;
+    for (int i = 0; i <= last; i++) {
+        int frameFlags = i < last ? (flags | ZMQ_SNDMORE) : (flags & ~ZMQ_SNDMORE);
+        if (!sendMsg(&msg[i].msg, frameFlags)) {
+            int error = QZmqError::getLastError();
+            msg.removeFirst(i);
+            errno = error;
+            return false;
         }
     }
+
+    msg.clear();
+    return true;
 }
 
 /**
- * @brief   See if the last received message has more parts to be received. 
+ * @brief   Send as many of the given messages as possible in one call.
+ *          Sending stops at the first message that cannot be sent. The ready-to-send
+ *          state is updated only once for the whole batch.
+ *          @sa QZmqSocket::onReadyToSend()
+ *          @note This function does not deallocate the given messages.
  * 
- * @return true     If the last received message has more parts.
- * @return false    If the last received message does not have more parts.
+ * @param msgs  An array of pointers to the messages to be sent.
+ * @param count Number of messages in the array.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return int  Number of messages sent. If it is less than count, 
+ *              use QZmqError::getLastError() to get the error code.
  */
-bool QZmqSocket::hasMoreParts()
-{    
-    int value = 0;
-    size_t size = sizeof(value);
-    getOption(ZMQ_RCVMORE, &value, &size);
-    return value == 1;
+int QZmqSocket::sendBatch(QZmqMessage * const *msgs, int count, int flags)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    int i = 0;
+    if (this->coalescer != NULL) {
+        while (i < count && coalesce(msgs[i]->msg, flags)) {
+            i++;
+        }
+        return i;
+    }
+
+    for (; i < count; i++) {
+        int rc = sendFrame(msgs[i]->msg, flags);
+        if (rc < 0) {
+            QZMQ_METRICS(sendFailed());
+            break;
+        }
+        QZMQ_METRICS(sent(rc));
+    }
+
+    batchSent(i, count);
+    return i;
 }
 
 /**
- * @brief   Returns the underlying raw socket. 
+ * @brief   Send as many of the given messages as possible in one call.
+ *          @sa QZmqSocket::sendBatch(QZmqMessage * const *, int, int)
  * 
- * @return void*    A pointer to the raw socket
+ * @param msgs  Messages to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return int  Number of messages sent. If it is less than the number of messages, 
+ *              use QZmqError::getLastError() to get the error code.
  */
-void* QZmqSocket::zmqSocket()
+int QZmqSocket::sendBatch(const QVector<QZmqMessage*> &msgs, int flags)
 {
-    return this->socket;
+    return sendBatch(msgs.constData(), msgs.size(), flags);
 }
 
 /**
- * @brief   Returns the maximum number of massages to be received through
- *          QZmqSocket::onMessage() signal at a time.
- *          @sa QZmqSocket::setMaximumThroughput()
+ * @brief   Send as many of the given frames as possible in one call.
+ *          The frames that are sent become empty. The rest are left untouched so that
+ *          they can be sent again later.
+ *          @sa QZmqSocket::sendBatch(QZmqMessage * const *, int, int)
  * 
- * @return int  Maximum number of messages emitted.
+ * @param frames    An array of frames to be sent.
+ * @param count     Number of frames in the array.
+ * @param flags     Refer to the documentation of zmq_msg_send().
+ * @return int      Number of frames sent. If it is less than count, 
+ *                  use QZmqError::getLastError() to get the error code.
  */
-int QZmqSocket::maximumThroughput()
+int QZmqSocket::sendBatch(QZmqFrame *frames, int count, int flags)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    int i = 0;
+    if (this->coalescer != NULL) {
+        while (i < count && coalesce(&frames[i].msg, flags)) {
+            i++;
+        }
+        return i;
+    }
+
+    for (; i < count; i++) {
+        int rc = sendFrame(&frames[i].msg, flags);
+        if (rc < 0) {
+            QZMQ_METRICS(sendFailed());
+            break;
+        }
+        QZMQ_METRICS(sent(rc));
+    }
+
+    batchSent(i, count);
+    return i;
+}
+
+/**
+ * @brief   Update the ready-to-send state after sending a batch of messages.
+ * 
+ * @param sent  Number of messages sent.
+ * @param count Number of messages in the batch.
+ */
+void QZmqSocket::batchSent(int sent, int count)
+{
+    if (sent < count) {
+        int error = QZmqError::getLastError();
+        if (error == EAGAIN) {
+            setWriteInterest(true);
+        }
+        // Keep the error code for the caller.
+        errno = error;
+    } else if (!hasPendingSends()) {
+        setWriteInterest(false);
+    }
+}
+
+/**
+ * @brief   Send a raw ØMQ message and keep track of the ready-to-send state.
+ * 
+ * @param msg   A pointer to the message to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return true     If the operation is successful.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::sendMsg(zmq_msg_t *msg, int flags)
+{
+    Q_ASSERT(this->socket != NULL);
+
+    if (this->coalescer != NULL) {
+        return coalesce(msg, flags);
+    }
+
+    int rc = sendFrame(msg, flags);
+    if (rc < 0) {
+        QZMQ_METRICS(sendFailed());
+        if (QZmqError::getLastError() == EAGAIN) {
+            // Non-blocking mode was requested and the message cannot be sent at the moment.
+            // Enable the write notifier to get notification when the socket is ready to send again.
+            setWriteInterest(true);
+        }
+        return false;
+    } else {
+        QZMQ_METRICS(sent(rc));
+        // For the moment, we can still send data over the socket. So, we do not need to worry
+        // about the ready-to-send event unless other messages are waiting for it.
+        if (!hasPendingSends()) {
+            setWriteInterest(false);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Add a message to the batch of coalescing mode. The batch is sent once it is due.
+ *          @sa QZmqSocket::setCoalescingMode()
+ * 
+ * @param msg   A pointer to the message. It becomes empty once it is in the batch.
+ * @param flags Refer to the documentation of zmq_msg_send(). Batches are always sent
+ *              with ZMQ_DONTWAIT. ZMQ_SNDMORE is not supported.
+ * @return true     If the message is in the batch.
+ * @return false    If the operation is not successful. EAGAIN is reported if the batch
+ *                  is full and cannot be sent at the moment.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::coalesce(zmq_msg_t *msg, int flags)
+{
+    if (flags & ZMQ_SNDMORE) {
+        errno = ENOTSUP;
+        return false;
+    }
+
+    size_t size = zmq_msg_size(msg);
+    if (!this->coalescer->hasRoom(size) && !flushCoalesced()) {
+        return false;
+    }
+    if (!this->coalescer->append(zmq_msg_data(msg), size)) {
+        return false;
+    }
+    // Messages are counted once their batch is sent.
+    zmq_msg_close(msg);
+    zmq_msg_init(msg);
+
+    if (this->coalescer->isDue()) {
+        // The message is taken over already. A batch that cannot be sent at the moment
+        // is sent once the socket is ready again.
+        if (!flushCoalesced() && QZmqError::getLastError() != EAGAIN) {
+            emit onError(this, QZmqError::getLastError());
+        }
+    } else if (!this->coalesceTimer->isActive()) {
+        this->coalesceTimer->start(this->coalescer->timeout());
+    }
+    return true;
+}
+
+/**
+ * @brief   Send a single frame, compressed if the socket has a compressor.
+ *          Only the last frame of a message is compressed, so that routing ids,
+ *          delimiters and topic frames stay as they are.
+ *          @sa QZmqSocket::setCompressor()
+ * 
+ * @param msg   A pointer to the frame to be sent. It becomes empty once it is sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return int  Number of bytes on the wire or -1 if the operation is not successful.
+ *              Use QZmqError::getLastError() to get the error code.
+ */
+int QZmqSocket::sendFrame(zmq_msg_t *msg, int flags)
+{
+    if (this->frameCompressor == NULL || (flags & ZMQ_SNDMORE)) {
+        return zmq_msg_send(msg, this->socket, flags);
+    }
+
+#ifdef QZMQ_WITH_METRICS
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    size_t size = zmq_msg_size(msg);
+    zmq_msg_t packed;
+    if (!this->frameCompressor->compress(msg, &packed)) {
+        return -1;
+    }
+    QZMQ_METRICS(compressed(size, zmq_msg_size(&packed), QZmqCompressor::isCompressed(&packed),
+                            timer.nsecsElapsed()));
+
+    int rc = zmq_msg_send(&packed, this->socket, flags);
+    if (rc < 0) {
+        // The original frame is kept, so that it can be sent again later.
+        // Frames that are sent as they are were moved to the packed frame.
+        int error = QZmqError::getLastError();
+        if (zmq_msg_size(msg) == 0) {
+            zmq_msg_move(msg, &packed);
+        }
+        zmq_msg_close(&packed);
+        errno = error;
+        return -1;
+    }
+    // Leave the frame empty as zmq_msg_send() does.
+    zmq_msg_close(msg);
+    zmq_msg_init(msg);
+    return rc;
+}
+
+/**
+ * @brief   Receive a single frame and decompress it if the socket has a compressor.
+ *          @sa QZmqSocket::sendFrame()
+ * 
+ * @param msg   A pointer to the frame that stores the incoming frame.
+ * @param flags Refer to the documentation of zmq_msg_recv().
+ * @return int  Number of bytes on the wire or -1 if the operation is not successful.
+ *              Use QZmqError::getLastError() to get the error code.
+ *              A frame that cannot be decompressed is dropped with the error of
+ *              QZmqCompressor::decompress().
+ */
+int QZmqSocket::receiveFrame(zmq_msg_t *msg, int flags)
+{
+    int rc = zmq_msg_recv(msg, this->socket, flags);
+    if (rc < 0 || this->frameCompressor == NULL || zmq_msg_more(msg)) {
+        return rc;
+    }
+
+#ifdef QZMQ_WITH_METRICS
+    QElapsedTimer timer;
+    timer.start();
+    bool packed = QZmqCompressor::isCompressed(msg);
+#endif
+    zmq_msg_t content;
+    if (!this->frameCompressor->decompress(msg, &content)) {
+        int error = QZmqError::getLastError();
+        zmq_msg_close(msg);
+        zmq_msg_init(msg);
+        errno = error;
+        return -1;
+    }
+    zmq_msg_move(msg, &content);
+    zmq_msg_close(&content);
+    QZMQ_METRICS(decompressed(packed, timer.nsecsElapsed()));
+    return rc;
+}
+
+/**
+ * @brief   Check if the socket is ready to send massages.
+ *          If the socket is ready, QZmqSocket::onReadyToSend() signal will be emitted.
+ */
+void QZmqSocket::checkReadyToSend()
+{
+    if (this->writeInterest) {
+        if (events() & ZMQ_POLLOUT) {
+            readyToSend();
+        }
+    }
+}
+
+/**
+ * @brief   Handle the socket being ready to send massages.
+ *          Queued messages and messages pushed to senders are sent first.
+ *          QZmqSocket::onReadyToSend() signal is emitted only if all of them are sent.
+ */
+void QZmqSocket::readyToSend()
+{
+    setWriteInterest(false);
+    // Messages in the batch were accepted before the ones in the send queue.
+    if (!flushCoalesced()) {
+        int error = QZmqError::getLastError();
+        if (error == EAGAIN) {
+            return;
+        }
+        emit onError(this, error);
+    }
+    if (!flushSendQueue()) {
+        return;
+    }
+    for (QZmqSender *sender : this->senders) {
+        if (!sender->flush()) {
+            return;
+        }
+    }
+    emit onReadyToSend(this);
+}
+
+/**
+ * @brief   Enqueue a message to be sent through the socket.
+ *          The message is sent right away if the send queue is empty and the socket is
+ *          ready. Otherwise, it is kept in the send queue and sent as soon as the socket
+ *          becomes ready again. On success, the content of the message is taken over and
+ *          the message becomes empty. On failure, the message is left untouched.
+ *          @note Like QZmqSocket::send(QZmqMessage*, int), this function does not deallocate
+ *          the given message.
+ *          @sa QZmqSocket::setSendQueueLimits()
+ * 
+ * @param msg   A pointer to the message to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return true     If the message is sent or queued.
+ * @return false    If the operation is not successful. EAGAIN is reported if the send queue is full.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::enqueue(QZmqMessage *msg, int flags)
+{
+    Q_ASSERT(msg != NULL);
+
+    QZmqFrame frame;
+    int rc = zmq_msg_move(&frame.msg, msg->msg);
+    if (rc != 0) {
+        return false;
+    }
+
+    if (!enqueue(std::move(frame), flags)) {
+        // Give the content back to the caller.
+        zmq_msg_move(msg->msg, &frame.msg);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Enqueue a frame to be sent through the socket.
+ *          On success, the frame becomes empty. On failure, the frame is left untouched.
+ *          @sa QZmqSocket::enqueue(QZmqMessage*, int)
+ * 
+ * @param frame The frame to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send().
+ * @return true     If the frame is sent or queued.
+ * @return false    If the operation is not successful. EAGAIN is reported if the send queue is full.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::enqueue(QZmqFrame &&frame, int flags)
+{
+    if (this->sendQueue.empty()) {
+        if (sendMsg(&frame.msg, flags)) {
+            return true;
+        }
+        if (QZmqError::getLastError() != EAGAIN) {
+            return false;
+        }
+    }
+
+    if (isSendQueueFull()) {
+        errno = EAGAIN;
+        return false;
+    }
+
+    pushToSendQueue(std::move(frame), flags);
+    return true;
+}
+
+/**
+ * @brief   Enqueue all frames of a multipart message to be sent through the socket.
+ *          The message is counted as a single message against the send queue limits.
+ *          On success, the multipart message becomes empty.
+ *          On failure, the frames that are already sent are removed and the frames that
+ *          are not sent yet are left in the message. Normally, that is the whole message.
+ *          @sa QZmqSocket::enqueue(QZmqMessage*, int)
+ * 
+ * @param msg   The multipart message to be sent.
+ * @param flags Refer to the documentation of zmq_msg_send(). ZMQ_SNDMORE is set as needed.
+ * @return true     If the message is sent or queued.
+ * @return false    If the operation is not successful. EAGAIN is reported if the send queue is full.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::enqueue(QZmqMultipartMessage &&msg, int flags)
+{
+    Q_ASSERT(!msg.isEmpty());
+
+    int last = msg.size() - 1;
+    int i = 0;
+    if (this->sendQueue.empty()) {
+        // Send as many frames as possible right away. ØMQ accepts either all or none of
+        // the frames of a message, so normally either all or none of them are queued.
+        for (; i <= last; i++) {
+            int frameFlags = i < last ? (flags | ZMQ_SNDMORE) : (flags & ~ZMQ_SNDMORE);
+            if (!sendMsg(&msg[i].msg, frameFlags)) {
+                int error = QZmqError::getLastError();
+                if (error != EAGAIN) {
+                    msg.removeFirst(i);
+                    errno = error;
+                    return false;
+                }
+                break;
+            }
+        }
+        if (i > last) {
+            msg.clear();
+            return true;
+        }
+    }
+
+    if (i == 0 && isSendQueueFull()) {
+        errno = EAGAIN;
+        return false;
+    }
+
+    for (; i <= last; i++) {
+        int frameFlags = i < last ? (flags | ZMQ_SNDMORE) : (flags & ~ZMQ_SNDMORE);
+        pushToSendQueue(std::move(msg[i]), frameFlags);
+    }
+    msg.clear();
+    return true;
+}
+
+/**
+ * @brief   See if the send queue has reached either of its limits.
+ *          Once the limits are reached, the queue stays full until it has drained to the
+ *          low water mark. @sa QZmqSocket::flushSendQueue()
+ * 
+ * @return true     If no more messages can be queued.
+ * @return false    If more messages can be queued.
+ */
+bool QZmqSocket::isSendQueueFull()
+{
+    if (this->sendQueueHighWater) {
+        return true;
+    }
+    if (this->sendQueueMessages >= this->sendQueueMaxMessages) {
+        return true;
+    }
+    return this->sendQueueMaxBytes > 0 && this->sendQueueSizeBytes >= this->sendQueueMaxBytes;
+}
+
+/**
+ * @brief   Check if messages are waiting for the socket to become ready to send, i.e.
+ *          queued messages, a sealed batch of coalescing mode or messages pushed to senders.
+ *          ØMQ signals the ready-to-send state only on edges, so the notification must stay
+ *          enabled while there are such messages.
+ */
+bool QZmqSocket::hasPendingSends()
+{
+    if (!this->sendQueue.empty()) {
+        return true;
+    }
+    if (this->coalescer != NULL && this->coalescer->isSealed()) {
+        return true;
+    }
+    for (QZmqSender *sender : this->senders) {
+        if (!sender->isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief   Append a frame to the send queue and emit QZmqSocket::onHighWater() signal
+ *          if the queue becomes full.
+ * 
+ * @param frame The frame to be queued.
+ * @param flags Flags to be used when sending the frame.
+ */
+void QZmqSocket::pushToSendQueue(QZmqFrame &&frame, int flags)
+{
+    this->sendQueueSizeBytes += frame.size();
+    if (!(flags & ZMQ_SNDMORE)) {
+        this->sendQueueMessages++;
+    }
+    this->sendQueue.push_back(QueuedFrame{std::move(frame), flags});
+
+    // Make sure that the queue is flushed when the socket becomes writable.
+    setWriteInterest(true);
+
+    if (!this->sendQueueHighWater && isSendQueueFull()) {
+        this->sendQueueHighWater = true;
+        emit onHighWater(this);
+    }
+}
+
+/**
+ * @brief   Send queued messages until the queue is drained or the socket cannot accept more.
+ *          QZmqSocket::onLowWater() signal is emitted once the queue has drained to half of
+ *          its limits after reaching the high water mark.
+ * 
+ * @return true     If the send queue is empty.
+ * @return false    If there are messages left in the send queue.
+ */
+bool QZmqSocket::flushSendQueue()
+{
+    while (!this->sendQueue.empty()) {
+        QueuedFrame &item = this->sendQueue.front();
+        size_t size = item.frame.size();
+        int flags = item.flags;
+        if (!sendMsg(&item.frame.msg, flags)) {
+            int error = QZmqError::getLastError();
+            if (error == EAGAIN) {
+                return false;
+            }
+            // Drop the rest of the failed message and carry on with the next one.
+            emit onError(this, error);
+            while (!this->sendQueue.empty()) {
+                QueuedFrame &dropped = this->sendQueue.front();
+                int droppedFlags = dropped.flags;
+                this->sendQueueSizeBytes -= dropped.frame.size();
+                this->sendQueue.pop_front();
+                if (!(droppedFlags & ZMQ_SNDMORE)) {
+                    this->sendQueueMessages--;
+                    break;
+                }
+            }
+        } else {
+            this->sendQueueSizeBytes -= size;
+            if (!(flags & ZMQ_SNDMORE)) {
+                this->sendQueueMessages--;
+            }
+            this->sendQueue.pop_front();
+        }
+
+        if (this->sendQueueHighWater &&
+            this->sendQueueMessages <= this->sendQueueMaxMessages / 2 &&
+            (this->sendQueueMaxBytes == 0 || this->sendQueueSizeBytes <= this->sendQueueMaxBytes / 2)) {
+            this->sendQueueHighWater = false;
+            emit onLowWater(this);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief   See if the last received message has more parts to be received. 
+ * 
+ * @return true     If the last received message has more parts.
+ * @return false    If the last received message does not have more parts.
+ */
+bool QZmqSocket::hasMoreParts()
+{    
+    int value = 0;
+    size_t size = sizeof(value);
+    getOption(ZMQ_RCVMORE, &value, &size);
+    return value == 1;
+}
+
+/**
+ * @brief   Returns the underlying raw socket. 
+ * 
+ * @return void*    A pointer to the raw socket
+ */
+void* QZmqSocket::zmqSocket()
+{
+    return this->socket;
+}
+
+/**
+ * @brief   Returns the maximum number of massages to be received through
+ *          QZmqSocket::onMessage() signal at a time.
+ *          @sa QZmqSocket::setMaximumThroughput()
+ * 
+ * @return int  Maximum number of messages emitted.
+ */
+int QZmqSocket::maximumThroughput()
 {
     return this->maxThroughput;
 }
@@ -465,4 +1506,478 @@ void QZmqSocket::setMaximumThroughput(int throughput)
     this->maxThroughput = throughput;
 }
 
+/**
+ * @brief   See if receiving is paused.
+ *          @sa QZmqSocket::setReceivePaused()
+ * 
+ * @return true     If messages are left in the socket.
+ * @return false    If messages are received and emitted.
+ */
+bool QZmqSocket::receivePaused()
+{
+    return this->readPaused;
+}
+
+/**
+ * @brief   Pause or resume receiving, e.g. while the consumer of the messages is behind.
+ *          While paused, messages are left in the socket, so ØMQ applies its high water
+ *          mark (ZMQ_RCVHWM) to the peers. Sending is not affected. Pending messages are
+ *          received in the next iteration of the event loop after resuming.
+ * 
+ * @param paused    Whether or not to stop receiving messages.
+ */
+void QZmqSocket::setReceivePaused(bool paused)
+{
+    if (this->readPaused == paused) {
+        return;
+    }
+    this->readPaused = paused;
+    // The reactor polls the socket in every iteration of the event loop, so messages that
+    // arrived while paused are picked up although ZMQ_FD does not signal them again.
+    updateEvents();
+}
+
+/**
+ * @brief   See if received messages are delivered in batches.
+ *          @sa QZmqSocket::setBatchMode()
+ * 
+ * @return true     If messages are delivered through QZmqSocket::onMessages() signal.
+ * @return false    If messages are delivered through QZmqSocket::onMessage() signal.
+ */
+bool QZmqSocket::batchMode()
+{
+    return this->batchEnabled;
+}
+
+/**
+ * @brief   Enable or disable batch mode.
+ *          In batch mode, all messages received in one pass (up to the maximum throughput)
+ *          are emitted at once through QZmqSocket::onMessages() signal and
+ *          QZmqSocket::onMessage() signal is not emitted.
+ *          The receiver of QZmqSocket::onMessages() signal owns the messages.
+ *          @sa QZmqSocket::batchMode()
+ * 
+ * @param enabled   Whether or not to deliver messages in batches.
+ */
+void QZmqSocket::setBatchMode(bool enabled)
+{
+    this->batchEnabled = enabled;
+}
+
+/**
+ * @brief   See if received messages are delivered as complete multipart messages.
+ *          @sa QZmqSocket::setMultipartMode()
+ * 
+ * @return true     If messages are delivered through QZmqSocket::onMultipartMessage() signal.
+ * @return false    If every frame is delivered separately.
+ */
+bool QZmqSocket::multipartMode()
+{
+    return this->multipartEnabled;
+}
+
+/**
+ * @brief   Enable or disable multipart mode.
+ *          In multipart mode, all frames of a message are collected into a
+ *          QZmqMultipartMessage that is emitted through QZmqSocket::onMultipartMessage()
+ *          signal once the last frame is received. QZmqSocket::onMessage() and
+ *          QZmqSocket::onMessages() signals are not emitted.
+ *          The receiver of QZmqSocket::onMultipartMessage() signal owns the message.
+ *          @sa QZmqSocket::multipartMode()
+ * 
+ * @param enabled   Whether or not to deliver complete multipart messages.
+ */
+void QZmqSocket::setMultipartMode(bool enabled)
+{
+    this->multipartEnabled = enabled;
+}
+
+/**
+ * @brief   See if small messages are packed into batch frames.
+ *          @sa QZmqSocket::setCoalescingMode()
+ * 
+ * @return true     If coalescing mode is enabled.
+ * @return false    Otherwise.
+ */
+bool QZmqSocket::coalescingMode()
+{
+    return this->coalescer != NULL;
+}
+
+/**
+ * @brief   Enable or disable coalescing mode.
+ *          In coalescing mode, sent messages are copied into a batch frame that is sent
+ *          once it holds enough messages or bytes, or once its first message has waited
+ *          long enough. Received batch frames are split into messages, which are emitted
+ *          through QZmqSocket::onMessages() signal, or through QZmqSocket::onMessage()
+ *          signal if the former is not connected. This saves the per-frame costs of ØMQ
+ *          and of the signals for tiny messages.
+ *          Both peers must use coalescing mode. Multipart messages are not supported.
+ *          Disabling coalescing mode sends the current batch first. If it cannot be sent,
+ *          coalescing mode stays enabled and the batch is kept as described for
+ *          QZmqSocket::flushCoalesced(), e.g. retry after QZmqSocket::onReadyToSend() signal.
+ *          Destroying the socket sends the current batch as well. If it cannot be sent, its
+ *          messages are reported through QZmqSocket::onCoalescedDropped() signal, which is
+ *          emitted from the destructor then.
+ *          @sa QZmqSocket::setCoalescingLimits()
+ *          @sa QZmqSocket::flushCoalesced()
+ * 
+ * @param enabled   Whether or not to pack messages into batch frames.
+ * @return true     If the mode is set.
+ * @return false    If the current batch cannot be sent. Use QZmqError::getLastError()
+ *                  to get the error code.
+ */
+bool QZmqSocket::setCoalescingMode(bool enabled)
+{
+    if (enabled == (this->coalescer != NULL)) {
+        return true;
+    }
+
+    if (enabled) {
+        this->coalescer = new QZmqCoalescer(this->coalesceMessages, this->coalesceBytes, this->coalesceDelay);
+        if (this->coalesceTimer == NULL) {
+            this->coalesceTimer = new QTimer(this);
+            this->coalesceTimer->setSingleShot(true);
+            this->coalesceTimer->setTimerType(Qt::PreciseTimer);
+            QObject::connect(this->coalesceTimer, &QTimer::timeout, this, &QZmqSocket::coalesceTimeout);
+        }
+    } else {
+        if (!flushCoalesced()) {
+            return false;
+        }
+        this->coalesceTimer->stop();
+        delete this->coalescer;
+        this->coalescer = NULL;
+    }
+    return true;
+}
+
+/**
+ * @brief   Set when a batch of coalescing mode is sent.
+ *          The deadline is checked whenever a message is added. Otherwise, a timer sends the
+ *          batch. The timer has a resolution of milliseconds, so a batch with a shorter
+ *          deadline is sent as soon as the event loop of the socket's thread regains control.
+ *          @sa QZmqSocket::setCoalescingMode()
+ * 
+ * @param messages  Maximum number of messages in a batch. 256 by default.
+ * @param bytes     Size of a batch in bytes that gets it sent.
+ * @param delay     Maximum time in microseconds that a message waits in the batch.
+ */
+void QZmqSocket::setCoalescingLimits(int messages, int bytes, int delay)
+{
+    this->coalesceMessages = messages;
+    this->coalesceBytes = bytes;
+    this->coalesceDelay = delay;
+    if (this->coalescer != NULL) {
+        this->coalescer->setLimits(messages, bytes, delay);
+    }
+}
+
+/**
+ * @brief   Send the current batch of coalescing mode right away, e.g. before a pause.
+ * 
+ * @return true     If the batch is sent or there is nothing to be sent.
+ * @return false    If the operation is not successful. On EAGAIN, the batch is kept and sent
+ *                  once the socket is ready again. Otherwise, the batch is discarded and
+ *                  QZmqSocket::onCoalescedDropped() signal reports how many messages are lost.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::flushCoalesced()
+{
+    if (this->coalescer == NULL || this->coalescer->isEmpty()) {
+        return true;
+    }
+    this->coalesceTimer->stop();
+
+    QZmqFrame *frame = this->coalescer->seal();
+    if (frame == NULL) {
+        return false;
+    }
+
+    int rc = sendFrame(frame->zmqMsg(), ZMQ_DONTWAIT);
+    if (rc < 0) {
+        int error = QZmqError::getLastError();
+        QZMQ_METRICS(sendFailed());
+        if (error == EAGAIN) {
+            setWriteInterest(true);
+        } else {
+            int count = this->coalescer->sealedMessages();
+            QZMQ_METRICS(coalescedDropped(count));
+            this->coalescer->discard();
+            emit onCoalescedDropped(this, count);
+        }
+        errno = error;
+        return false;
+    }
+
+    QZMQ_METRICS(coalescedSent(this->coalescer->sealedMessages(), this->coalescer->sealedBytes()));
+    this->coalescer->discard();
+    return true;
+}
+
+/**
+ * @brief   This is the slot (function) that is called when the deadline of a batch of
+ *          coalescing mode has passed.
+ */
+void QZmqSocket::coalesceTimeout()
+{
+    if (!flushCoalesced()) {
+        int error = QZmqError::getLastError();
+        if (error != EAGAIN) {
+            emit onError(this, error);
+        }
+    }
+}
+
+/**
+ * @brief   Set the limits of the send queue.
+ *          By default, the queue holds up to 1000 messages regardless of their size.
+ *          Once the queue holds the given number of messages or bytes,
+ *          QZmqSocket::onHighWater() signal is emitted and QZmqSocket::enqueue() fails
+ *          with EAGAIN until the queue has drained to half of its limits and
+ *          QZmqSocket::onLowWater() signal is emitted. The byte limit is checked before a
+ *          message is queued, so the queue may exceed it by one message.
+ *          Messages sent with QZmqSocket::send() bypass the queue and may overtake
+ *          queued messages.
+ *          @sa QZmqSocket::enqueue()
+ * 
+ * @param messages  Maximum number of queued messages. 0 disables queueing, i.e.
+ *                  QZmqSocket::enqueue() fails with EAGAIN whenever the socket cannot
+ *                  send right away.
+ * @param bytes     Maximum number of queued bytes. 0 means no limit.
+ */
+void QZmqSocket::setSendQueueLimits(int messages, qint64 bytes)
+{
+    this->sendQueueMaxMessages = messages;
+    this->sendQueueMaxBytes = bytes;
+}
+
+/**
+ * @brief   Returns the maximum number of messages in the send queue.
+ *          @sa QZmqSocket::setSendQueueLimits()
+ * 
+ * @return int  Maximum number of queued messages.
+ */
+int QZmqSocket::sendQueueMessageLimit()
+{
+    return this->sendQueueMaxMessages;
+}
+
+/**
+ * @brief   Returns the maximum number of bytes in the send queue.
+ *          @sa QZmqSocket::setSendQueueLimits()
+ * 
+ * @return qint64   Maximum number of queued bytes. 0 means no limit.
+ */
+qint64 QZmqSocket::sendQueueByteLimit()
+{
+    return this->sendQueueMaxBytes;
+}
+
+/**
+ * @brief   Returns the number of messages waiting in the send queue.
+ * 
+ * @return int  Number of queued messages.
+ */
+int QZmqSocket::sendQueueSize()
+{
+    return this->sendQueueMessages;
+}
+
+/**
+ * @brief   Returns the number of bytes waiting in the send queue.
+ * 
+ * @return qint64   Number of queued bytes.
+ */
+qint64 QZmqSocket::sendQueueBytes()
+{
+    return this->sendQueueSizeBytes;
+}
+
+/**
+ * @brief   Create a handle for sending messages through this socket from other threads.
+ *          Messages pushed to the sender from any thread are sent by the thread of the socket
+ *          without locks or per-message allocations. Each sender has its own bounded queue.
+ *          The sender is owned by the socket and must not be used after the socket is destroyed.
+ *          This function must be called from the thread of the socket.
+ *          @sa QZmqSender::send()
+ * 
+ * @param capacity  Maximum number of pending messages in the sender.
+ * @return QZmqSender*  A pointer to the created sender.
+ */
+QZmqSender* QZmqSocket::createSender(int capacity)
+{
+    QZmqSender *sender = new QZmqSender(this, capacity);
+    this->senders.append(sender);
+    return sender;
+}
+
+/**
+ * @brief   Start monitoring the connection events of the socket.
+ *          An inproc PAIR socket receives the events and the monitor turns them into
+ *          signals and per endpoint statistics. The monitor is owned by the socket.
+ *          Refer to the documentation of zmq_socket_monitor().
+ * 
+ * @param events    Events to be monitored. ZMQ_EVENT_ALL by default.
+ * @return QZmqMonitor*     A pointer to the monitor.
+ *                          NULL is returned if monitoring cannot be started.
+ *                          Use QZmqError::getLastError() to get the error code.
+ */
+QZmqMonitor* QZmqSocket::enableMonitor(int events)
+{
+    disableMonitor();
+
+    QZmqMonitor *monitor = new QZmqMonitor(this);
+    if (!monitor->start(this->context, events)) {
+        int error = QZmqError::getLastError();
+        delete monitor;
+        errno = error;
+        return NULL;
+    }
+    this->socketMonitor = monitor;
+    return monitor;
+}
+
+/**
+ * @brief   Stop monitoring the socket and destroy the monitor.
+ */
+void QZmqSocket::disableMonitor()
+{
+    if (this->socketMonitor != NULL) {
+        delete this->socketMonitor;
+        this->socketMonitor = NULL;
+    }
+}
+
+/**
+ * @brief   Returns the monitor of the socket.
+ *          @sa QZmqSocket::enableMonitor()
+ * 
+ * @return QZmqMonitor*     A pointer to the monitor or NULL if the socket is not monitored.
+ */
+QZmqMonitor* QZmqSocket::monitor()
+{
+    return this->socketMonitor;
+}
+
+/**
+ * @brief   Returns a snapshot of the counters of the socket.
+ *          All counters are zero if the library is built without metrics.
+ *          @sa QZmqReactor::stats()
+ * 
+ * @return QZmqSocketStats  Counters of the socket.
+ */
+QZmqSocketStats QZmqSocket::stats()
+{
+    QZmqSocketStats stats = QZmqSocketStats();
+    if (this->metrics != NULL) {
+        this->metrics->addTo(stats);
+    }
+    return stats;
+}
+
+/**
+ * @brief   Reset the counters of the socket.
+ */
+void QZmqSocket::resetStats()
+{
+    if (this->metrics != NULL) {
+        this->metrics->reset();
+    }
+}
+
+/**
+ * @brief   Enable or disable the histograms of receive batch sizes and signal handler times.
+ *          Measuring handler times costs two clock reads per emitted signal.
+ * 
+ * @param enabled   Whether or not to record the histograms.
+ */
+void QZmqSocket::setStatsHistogramsEnabled(bool enabled)
+{
+    if (this->metrics != NULL) {
+        this->metrics->histogramsEnabled = enabled;
+    }
+}
+
+/**
+ * @brief   Returns the pool of the messages emitted by the socket.
+ *          @sa QZmqSocket::setMessagePool()
+ * 
+ * @return QZmqMessagePool*     A pointer to the message pool or NULL if messages are not pooled.
+ */
+QZmqMessagePool* QZmqSocket::messagePool()
+{
+    return this->pool;
+}
+
+/**
+ * @brief   Set the pool of the messages emitted by the socket.
+ *          Received messages are taken from the pool instead of being allocated.
+ *          Receivers must use QZmqMessage::release() instead of delete to give the messages
+ *          back to the pool. The pool must belong to the thread of the socket.
+ *          @sa QZmqMessagePool::instance()
+ * 
+ * @param pool  A pointer to the message pool or NULL to allocate every message.
+ */
+void QZmqSocket::setMessagePool(QZmqMessagePool *pool)
+{
+    this->pool = pool;
+}
+
+/**
+ * @brief   Returns the compressor of the socket.
+ *          @sa QZmqSocket::setCompressor()
+ * 
+ * @return QZmqCompressor*  A pointer to the compressor or NULL if frames are sent as they are.
+ */
+QZmqCompressor* QZmqSocket::compressor()
+{
+    return this->frameCompressor;
+}
+
+/**
+ * @brief   Set the compressor of the socket. The last frame of every sent message is
+ *          compressed if it is large enough. The last frame of every received message is
+ *          restored. Both peers must use a compressor.
+ *          Compression is refused for PUB, XPUB, SUB and XSUB sockets, because compressed
+ *          frames would not match the subscriptions of the subscribers.
+ *          Received frames that are decompressed do not keep their metadata, e.g. zmq_msg_gets().
+ *          @sa QZmqCompressor::create()
+ * 
+ * @param compressor    A pointer to the compressor or NULL to send frames as they are.
+ *                      On success, the socket takes the ownership and deletes the previous
+ *                      compressor.
+ * @return true     If the operation is successful.
+ * @return false    With ENOTSUP for publish-subscribe sockets.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqSocket::setCompressor(QZmqCompressor *compressor)
+{
+    if (compressor != NULL) {
+        int type = 0;
+        size_t size = sizeof(type);
+        if (!getOption(ZMQ_TYPE, &type, &size)) {
+            return false;
+        }
+        if (type == ZMQ_PUB || type == ZMQ_XPUB || type == ZMQ_SUB || type == ZMQ_XSUB) {
+            errno = ENOTSUP;
+            return false;
+        }
+
+        // Limit the frames restored from the size given by the peer like ØMQ does.
+        qint64 maxMessageSize = -1;
+        size = sizeof(maxMessageSize);
+        if (compressor->maxSize == 0 && getOption(ZMQ_MAXMSGSIZE, &maxMessageSize, &size) &&
+            maxMessageSize > 0) {
+            compressor->setMaxFrameSize(static_cast<size_t>(maxMessageSize));
+        }
+    }
+
+    if (this->frameCompressor != NULL && this->frameCompressor != compressor) {
+        delete this->frameCompressor;
+    }
+    this->frameCompressor = compressor;
+    return true;
+}
+
 QZMQ_END_NAMESPACE
\ No newline at end of file
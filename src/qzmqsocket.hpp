@@ -16,19 +16,32 @@
 #define __QZMQ_SOCKET_H__
 
 #include "qzmqcommon.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqsocketmetrics.hpp"
 #include <zmq.h>
 #include <QObject>
+#include <QVector>
+#include <deque>
 
 QZMQ_BEGIN_NAMESPACE
 
-class QTimer;
 class QSocketNotifier;
+class QTimer;
 class QZmqMessage;
+class QZmqMultipartMessage;
+class QZmqSender;
+class QZmqMessagePool;
+class QZmqReactor;
+class QZmqContext;
+class QZmqMonitor;
+class QZmqCompressor;
+class QZmqCoalescer;
 class QZMQ_API QZmqSocket : public QObject
 {
     Q_OBJECT
 public:
     static QZmqSocket* create(int type, QObject* parent=nullptr);
+    static QZmqSocket* create(QZmqContext *context, int type, QObject* parent=nullptr);
     virtual ~QZmqSocket();
     bool setOption(int option, const void *value, size_t len);
     bool getOption(int option, void *value, size_t *len);
@@ -36,38 +49,144 @@ public:
     bool unbind(const char *address);
     bool connect(const char *address);
     bool disconnect(const char *address);
+#ifdef ZMQ_BUILD_DRAFT_API
+    bool join(const char *group);
+    bool leave(const char *group);
+#endif
     bool send(QZmqMessage *msg, int flags=ZMQ_DONTWAIT);
     bool receive(QZmqMessage *msg, int flags=ZMQ_DONTWAIT);
+    bool send(QZmqFrame &&frame, int flags=ZMQ_DONTWAIT);
+    bool receive(QZmqFrame &frame, int flags=ZMQ_DONTWAIT);
+    bool send(QZmqMultipartMessage &&msg, int flags=ZMQ_DONTWAIT);
+    int sendBatch(QZmqMessage * const *msgs, int count, int flags=ZMQ_DONTWAIT);
+    int sendBatch(const QVector<QZmqMessage*> &msgs, int flags=ZMQ_DONTWAIT);
+    int sendBatch(QZmqFrame *frames, int count, int flags=ZMQ_DONTWAIT);
+    bool enqueue(QZmqMessage *msg, int flags=ZMQ_DONTWAIT);
+    bool enqueue(QZmqFrame &&frame, int flags=ZMQ_DONTWAIT);
+    bool enqueue(QZmqMultipartMessage &&msg, int flags=ZMQ_DONTWAIT);
+    void setSendQueueLimits(int messages, qint64 bytes=0);
+    int sendQueueMessageLimit();
+    qint64 sendQueueByteLimit();
+    int sendQueueSize();
+    qint64 sendQueueBytes();
+    QZmqSender* createSender(int capacity=4096);
+    QZmqMonitor* enableMonitor(int events=ZMQ_EVENT_ALL);
+    void disableMonitor();
+    QZmqMonitor* monitor();
+    QZmqSocketStats stats();
+    void resetStats();
+    void setStatsHistogramsEnabled(bool enabled);
     bool hasMoreParts();
     int maximumThroughput();
     void setMaximumThroughput(int throughput);
+    bool receivePaused();
+    void setReceivePaused(bool paused);
+    bool batchMode();
+    void setBatchMode(bool enabled);
+    bool multipartMode();
+    void setMultipartMode(bool enabled);
+    bool coalescingMode();
+    bool setCoalescingMode(bool enabled);
+    void setCoalescingLimits(int messages, int bytes=16384, int delay=100);
+    bool flushCoalesced();
+    QZmqMessagePool* messagePool();
+    void setMessagePool(QZmqMessagePool *pool);
+    QZmqCompressor* compressor();
+    bool setCompressor(QZmqCompressor *compressor);
     void* zmqSocket();
+    // Defined in qzmqcodec.hpp
+    template<typename T, typename Handler>
+    QMetaObject::Connection onTypedMessage(const QObject *context, Handler handler);
+    template<typename T>
+    bool sendTyped(const T &value, int flags=ZMQ_DONTWAIT);
 
 signals:
     void onMessage(QZmqSocket *socket, QZmqMessage *msg);
+    void onMessages(QZmqSocket *socket, const QVector<QZmqMessage*> &msgs);
+    void onMultipartMessage(QZmqSocket *socket, QZmqMultipartMessage *msg);
     void onReadyToSend(QZmqSocket *socket);
+    void onHighWater(QZmqSocket *socket);
+    void onLowWater(QZmqSocket *socket);
     void onError(QZmqSocket *socket, int error);
+    void onCoalescedDropped(QZmqSocket *socket, int count);
 
 protected slots:
     void readActivated(int socket);
     void writeActivated(int socket);
-    void onAboutToBlock();
-    void onAwake();
-    void onWakeUpTimer();
+    void coalesceTimeout();
 
 protected:
+    friend class QZmqReactor;
+    friend class QZmqSender;
     QZmqSocket(QObject* parent=nullptr);
     int events();
     void receiveAll();
+    void receiveBatch();
+    void receiveMultipart();
+    void receiveCoalesced();
+    bool unpack(QZmqFrame &frame);
+    bool coalesce(zmq_msg_t *msg, int flags);
+    QZmqMessage* createMessage();
     void checkReadyToSend();
+    void readyToSend();
+    bool isSendQueueFull();
+    bool hasPendingSends();
+    void pushToSendQueue(QZmqFrame &&frame, int flags);
+    bool flushSendQueue();
+    bool sendMsg(zmq_msg_t *msg, int flags);
+    int sendFrame(zmq_msg_t *msg, int flags);
+    int receiveFrame(zmq_msg_t *msg, int flags);
+    void batchSent(int sent, int count);
+    void setWriteInterest(bool enabled);
+    void updateEvents();
+    void processEvents(int events);
+    void clearFdPoller();
 
     void *socket;
+    void *fdPoller;
+    QZmqContext *context;
+    QZmqMonitor *socketMonitor;
+    QZmqSocketMetrics *metrics;
     QSocketNotifier *readNotifier;
     QSocketNotifier *writeNotifier;
-    QTimer *wakeUpTimer;
+    bool writeInterest;
+    bool readPaused;
+    QZmqReactor *reactor;
+    int reactorIndex;
     int maxThroughput;
+    bool batchEnabled;
+    bool multipartEnabled;
+    QZmqMultipartMessage *partial;
+    QZmqMessagePool *pool;
+    QZmqCompressor *frameCompressor;
+    QZmqCoalescer *coalescer;
+    QTimer *coalesceTimer;
+    int coalesceMessages;
+    int coalesceBytes;
+    int coalesceDelay;
+    QVector<QZmqMessage*> batch;
+
+    struct QueuedFrame
+    {
+        QZmqFrame frame;
+        int flags;
+    };
+
+    std::deque<QueuedFrame> sendQueue;
+    int sendQueueMaxMessages;
+    qint64 sendQueueMaxBytes;
+    int sendQueueMessages;
+    qint64 sendQueueSizeBytes;
+    bool sendQueueHighWater;
+    QVector<QZmqSender*> senders;
 };
 
 QZMQ_END_NAMESPACE
 
+#ifdef QZMQ_NAMESPACE
+Q_DECLARE_METATYPE(QVector<QZMQ_NAMESPACE::QZmqMessage*>)
+#else
+Q_DECLARE_METATYPE(QVector<QZmqMessage*>)
+#endif
+
 #endif // __QT_ZMQ_SOCKET_H__
\ No newline at end of file
@@ -0,0 +1,122 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqsocketmetrics.hpp"
+#include "qzmqerror.hpp"
+#include <cerrno>
+
+QZMQ_BEGIN_NAMESPACE
+
+QZmqSocketMetrics::QZmqSocketMetrics()
+{
+    this->histogramsEnabled = false;
+    reset();
+}
+
+// Add the counters to the given snapshot, e.g. to aggregate all sockets of a thread.
+void QZmqSocketMetrics::addTo(QZmqSocketStats &stats) const
+{
+    stats.messagesReceived += this->messagesReceived.loadRelaxed();
+    stats.bytesReceived += this->bytesReceived.loadRelaxed();
+    stats.messagesSent += this->messagesSent.loadRelaxed();
+    stats.bytesSent += this->bytesSent.loadRelaxed();
+    stats.receiveErrors += this->receiveErrors.loadRelaxed();
+    stats.sendErrors += this->sendErrors.loadRelaxed();
+    stats.sendAgain += this->sendAgain.loadRelaxed();
+    stats.receivePasses += this->receivePasses.loadRelaxed();
+    stats.throughputLimitHits += this->throughputLimitHits.loadRelaxed();
+    stats.framesCompressed += this->framesCompressed.loadRelaxed();
+    stats.compressionInputBytes += this->compressionInputBytes.loadRelaxed();
+    stats.compressionOutputBytes += this->compressionOutputBytes.loadRelaxed();
+    stats.compressionTime += this->compressionTime.loadRelaxed();
+    stats.framesDecompressed += this->framesDecompressed.loadRelaxed();
+    stats.decompressionTime += this->decompressionTime.loadRelaxed();
+    stats.coalescedFramesSent += this->coalescedFramesSent.loadRelaxed();
+    stats.coalescedFramesReceived += this->coalescedFramesReceived.loadRelaxed();
+    stats.coalescedMessagesDropped += this->coalescedMessagesDropped.loadRelaxed();
+    for (int i = 0; i < QZMQ_HISTOGRAM_BUCKETS; i++) {
+        stats.batchSizes[i] += this->batchSizes[i].loadRelaxed();
+        stats.handlerTimes[i] += this->handlerTimes[i].loadRelaxed();
+    }
+}
+
+void QZmqSocketMetrics::reset()
+{
+    this->messagesReceived.storeRelaxed(0);
+    this->bytesReceived.storeRelaxed(0);
+    this->messagesSent.storeRelaxed(0);
+    this->bytesSent.storeRelaxed(0);
+    this->receiveErrors.storeRelaxed(0);
+    this->sendErrors.storeRelaxed(0);
+    this->sendAgain.storeRelaxed(0);
+    this->receivePasses.storeRelaxed(0);
+    this->throughputLimitHits.storeRelaxed(0);
+    this->framesCompressed.storeRelaxed(0);
+    this->compressionInputBytes.storeRelaxed(0);
+    this->compressionOutputBytes.storeRelaxed(0);
+    this->compressionTime.storeRelaxed(0);
+    this->framesDecompressed.storeRelaxed(0);
+    this->decompressionTime.storeRelaxed(0);
+    this->coalescedFramesSent.storeRelaxed(0);
+    this->coalescedFramesReceived.storeRelaxed(0);
+    this->coalescedMessagesDropped.storeRelaxed(0);
+    for (int i = 0; i < QZMQ_HISTOGRAM_BUCKETS; i++) {
+        this->batchSizes[i].storeRelaxed(0);
+        this->handlerTimes[i].storeRelaxed(0);
+    }
+}
+
+// EAGAIN only means that there is nothing to receive at the moment.
+void QZmqSocketMetrics::receiveFailed()
+{
+    if (QZmqError::getLastError() != EAGAIN) {
+        add(this->receiveErrors, 1);
+    }
+}
+
+// EAGAIN is counted separately since it is the back pressure of the socket.
+void QZmqSocketMetrics::sendFailed()
+{
+    if (QZmqError::getLastError() == EAGAIN) {
+        add(this->sendAgain, 1);
+    } else {
+        add(this->sendErrors, 1);
+    }
+}
+
+// Number of messages received in one pass.
+void QZmqSocketMetrics::recordBatch(int size)
+{
+    add(this->receivePasses, 1);
+    if (this->histogramsEnabled) {
+        add(this->batchSizes[bucket(size)], 1);
+    }
+}
+
+void QZmqSocketMetrics::recordHandlerTime(qint64 nsecs)
+{
+    add(this->handlerTimes[bucket(nsecs)], 1);
+}
+
+int QZmqSocketMetrics::bucket(quint64 value)
+{
+    int i = 0;
+    while (value != 0 && i < QZMQ_HISTOGRAM_BUCKETS - 1) {
+        value >>= 1;
+        i++;
+    }
+    return i;
+}
+
+QZMQ_END_NAMESPACE
@@ -0,0 +1,155 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_SOCKET_METRICS_H__
+#define __QZMQ_SOCKET_METRICS_H__
+
+#include "qzmqcommon.hpp"
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+QZMQ_BEGIN_NAMESPACE
+
+constexpr int QZMQ_HISTOGRAM_BUCKETS = 32;
+
+// A snapshot of the counters of a socket or of all sockets of a thread.
+// Bucket i of a histogram counts values in [2^(i-1), 2^i), bucket 0 counts zeros.
+struct QZmqSocketStats
+{
+    quint64 messagesReceived;
+    quint64 bytesReceived;
+    quint64 messagesSent;
+    quint64 bytesSent;
+    quint64 receiveErrors;
+    quint64 sendErrors;
+    quint64 sendAgain;
+    quint64 receivePasses;
+    quint64 throughputLimitHits;
+    // Compression, @sa QZmqSocket::setCompressor(). The compression ratio is
+    // compressionInputBytes / compressionOutputBytes.
+    quint64 framesCompressed;       // Frames sent compressed
+    quint64 compressionInputBytes;  // Size of the frames passed to the compressor
+    quint64 compressionOutputBytes; // Size of those frames on the wire
+    quint64 compressionTime;        // Nanoseconds spent in compression
+    quint64 framesDecompressed;     // Frames received compressed
+    quint64 decompressionTime;      // Nanoseconds spent in decompression
+    // Coalescing mode, @sa QZmqSocket::setCoalescingMode(). Messages are counted as well.
+    quint64 coalescedFramesSent;
+    quint64 coalescedFramesReceived;
+    quint64 coalescedMessagesDropped;   // Messages of batches that failed to be sent
+    quint64 batchSizes[QZMQ_HISTOGRAM_BUCKETS];
+    quint64 handlerTimes[QZMQ_HISTOGRAM_BUCKETS];
+};
+
+// Counters of a socket. They are updated by the thread of the socket only, so
+// relaxed loads and stores are enough and other threads can still read them.
+class QZMQ_API QZmqSocketMetrics
+{
+public:
+    QZmqSocketMetrics();
+    void addTo(QZmqSocketStats &stats) const;
+    void reset();
+    void recordBatch(int size);
+    void recordHandlerTime(qint64 nsecs);
+
+    inline void add(QAtomicInteger<quint64> &counter, quint64 value) { counter.storeRelaxed(counter.loadRelaxed() + value); }
+    inline void received(size_t size) { add(this->messagesReceived, 1); add(this->bytesReceived, size); }
+    inline void sent(size_t size) { add(this->messagesSent, 1); add(this->bytesSent, size); }
+    inline void receivePass(int count, int limit)
+    {
+        recordBatch(count);
+        if (count >= limit) {
+            add(this->throughputLimitHits, 1);
+        }
+    }
+    inline void compressed(size_t in, size_t out, bool packed, qint64 nsecs)
+    {
+        if (packed) {
+            add(this->framesCompressed, 1);
+        }
+        add(this->compressionInputBytes, in);
+        add(this->compressionOutputBytes, out);
+        add(this->compressionTime, nsecs);
+    }
+    inline void decompressed(bool packed, qint64 nsecs)
+    {
+        if (packed) {
+            add(this->framesDecompressed, 1);
+            add(this->decompressionTime, nsecs);
+        }
+    }
+    inline void coalescedSent(int count, size_t size)
+    {
+        add(this->coalescedFramesSent, 1);
+        add(this->messagesSent, count);
+        add(this->bytesSent, size);
+    }
+    inline void coalescedDropped(int count) { add(this->coalescedMessagesDropped, count); }
+    inline void coalescedReceived() { add(this->coalescedFramesReceived, 1); }
+    void receiveFailed();
+    void sendFailed();
+
+    QAtomicInteger<quint64> messagesReceived;
+    QAtomicInteger<quint64> bytesReceived;
+    QAtomicInteger<quint64> messagesSent;
+    QAtomicInteger<quint64> bytesSent;
+    QAtomicInteger<quint64> receiveErrors;
+    QAtomicInteger<quint64> sendErrors;
+    QAtomicInteger<quint64> sendAgain;
+    QAtomicInteger<quint64> receivePasses;
+    QAtomicInteger<quint64> throughputLimitHits;
+    QAtomicInteger<quint64> framesCompressed;
+    QAtomicInteger<quint64> compressionInputBytes;
+    QAtomicInteger<quint64> compressionOutputBytes;
+    QAtomicInteger<quint64> compressionTime;
+    QAtomicInteger<quint64> framesDecompressed;
+    QAtomicInteger<quint64> decompressionTime;
+    QAtomicInteger<quint64> coalescedFramesSent;
+    QAtomicInteger<quint64> coalescedFramesReceived;
+    QAtomicInteger<quint64> coalescedMessagesDropped;
+    QAtomicInteger<quint64> batchSizes[QZMQ_HISTOGRAM_BUCKETS];
+    QAtomicInteger<quint64> handlerTimes[QZMQ_HISTOGRAM_BUCKETS];
+    bool histogramsEnabled;
+
+protected:
+    Q_DISABLE_COPY(QZmqSocketMetrics);
+    static int bucket(quint64 value);
+};
+
+// Measures the time spent in a signal handler if histograms are enabled.
+class QZmqHandlerTimer
+{
+public:
+    inline QZmqHandlerTimer(QZmqSocketMetrics *metrics) : metrics(metrics->histogramsEnabled ? metrics : NULL)
+    {
+        if (this->metrics != NULL) {
+            this->timer.start();
+        }
+    }
+
+    inline ~QZmqHandlerTimer()
+    {
+        if (this->metrics != NULL) {
+            this->metrics->recordHandlerTime(this->timer.nsecsElapsed());
+        }
+    }
+
+protected:
+    QZmqSocketMetrics *metrics;
+    QElapsedTimer timer;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_SOCKET_METRICS_H__
@@ -0,0 +1,451 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qzmqworkerpool.hpp"
+#include "qzmqsocket.hpp"
+#include "qzmqframe.hpp"
+#include "qzmqmultipartmessage.hpp"
+#include "qzmqerror.hpp"
+#include <QMetaMethod>
+#include <cerrno>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+QZMQ_BEGIN_NAMESPACE
+
+// Messages from workers to the pool are [routing id][type][payload...]
+constexpr char WORKER_READY = 'R';
+constexpr char WORKER_REPLY = 'D';
+constexpr int WORKER_SEND_QUEUE_LIMIT = 65536;
+constexpr int THROUGHPUT_WINDOW = 1000;     // Milliseconds
+
+/**
+ * @brief   Construct a new QZmqWorker::QZmqWorker object.
+ * 
+ * @param index     Index of the worker in the pool.
+ * @param endpoint  Endpoint of the backend socket of the pool.
+ * @param parent    Parent object of the worker.
+ */
+QZmqWorker::QZmqWorker(int index, const QByteArray &endpoint, QObject *parent) : QThread(parent)
+{
+    this->workerIndex = index;
+    this->cpu = -1;
+    this->endpoint = endpoint;
+    this->socket = NULL;
+}
+
+/**
+ * @brief   Destroy the QZmqWorker::QZmqWorker object.
+ *          The worker thread must be stopped before.
+ */
+QZmqWorker::~QZmqWorker()
+{
+    Q_ASSERT(!isRunning());
+}
+
+/**
+ * @brief   Returns the index of the worker in the pool.
+ * 
+ * @return int  Index of the worker.
+ */
+int QZmqWorker::index()
+{
+    return this->workerIndex;
+}
+
+/**
+ * @brief   Send the reply of a request back to the pool.
+ *          This function must be called from the worker thread.
+ *          On success, the message becomes empty. On failure, the frames of the reply
+ *          that are not sent are left in the message.
+ * 
+ * @param msg   The reply.
+ * @return true     If the reply is sent or queued.
+ * @return false    If the operation is not successful.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqWorker::reply(QZmqMultipartMessage &&msg)
+{
+    Q_ASSERT(this->socket != NULL);
+    Q_ASSERT(QThread::currentThread() == this);
+
+    int size = msg.size();
+    msg.prepend(QZmqFrame(&WORKER_REPLY, 1));
+    if (!this->socket->enqueue(std::move(msg))) {
+        int error = QZmqError::getLastError();
+        if (msg.size() > size) {
+            msg.removeFirst(msg.size() - size);
+        }
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Routing id of the socket of a worker.
+ *          Routing ids must not start with a zero byte.
+ * 
+ * @param index     Index of the worker.
+ * @return QByteArray   The routing id.
+ */
+QByteArray QZmqWorker::routingId(int index)
+{
+    QByteArray id(1 + sizeof(index), 'w');
+    memcpy(id.data() + 1, &index, sizeof(index));
+    return id;
+}
+
+/**
+ * @brief   Entry point of the worker thread.
+ *          The socket of the worker is created, used and destroyed in this thread.
+ */
+void QZmqWorker::run()
+{
+#ifdef Q_OS_LINUX
+    if (this->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(this->cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    this->socket = QZmqSocket::create(ZMQ_DEALER);
+    if (this->socket == NULL) {
+        return;
+    }
+
+    QByteArray id = routingId(this->workerIndex);
+    this->socket->setOption(ZMQ_ROUTING_ID, id.constData(), id.size());
+    this->socket->setMultipartMode(true);
+    this->socket->setSendQueueLimits(WORKER_SEND_QUEUE_LIMIT);
+
+    // The worker object lives in the thread of the pool. So, the socket is used as the
+    // context of the connection to handle requests in the worker thread.
+    QObject::connect(this->socket, &QZmqSocket::onMultipartMessage, this->socket,
+                     [this](QZmqSocket *socket, QZmqMultipartMessage *msg) {
+        static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqWorker::onRequest);
+        if (isSignalConnected(signal)) {
+            emit onRequest(this, msg);
+        } else {
+            delete msg;
+        }
+    });
+
+    if (this->socket->connect(this->endpoint.constData())) {
+        this->socket->enqueue(QZmqFrame(&WORKER_READY, 1));
+        exec();
+    }
+
+    delete this->socket;
+    this->socket = NULL;
+}
+
+/**
+ * @brief   Construct a new QZmqWorkerPool::QZmqWorkerPool object
+ * 
+ * @param parent Parent object of the pool.
+ */
+QZmqWorkerPool::QZmqWorkerPool(QObject *parent) : QObject(parent)
+{
+    this->backend = NULL;
+    this->nextWorker = 0;
+}
+
+/**
+ * @brief   Destroy the QZmqWorkerPool::QZmqWorkerPool object.
+ *          Worker threads are stopped.
+ */
+QZmqWorkerPool::~QZmqWorkerPool()
+{
+    stop();
+    qDeleteAll(this->workers);
+    this->workers.clear();
+
+    if (this->backend != NULL) {
+        delete this->backend;
+        this->backend = NULL;
+    }
+}
+
+/**
+ * @brief   Create a pool of worker threads.
+ *          Each worker has its own event loop and a DEALER socket connected to a ROUTER
+ *          socket of the pool over inproc transport. The pool must be used from the thread
+ *          in which it is created. Connect to QZmqWorker::onRequest() of the workers with
+ *          Qt::DirectConnection to handle the requests in the worker threads, then start the pool.
+ * 
+ * @param count     Number of worker threads.
+ * @param parent    Parent object of the created pool.
+ * @return QZmqWorkerPool*  A pointer to the created pool.
+ *                          NULL is returned if the pool creation is failed.
+ *                          Use QZmqError::getLastError() to get the error code.
+ */
+QZmqWorkerPool* QZmqWorkerPool::create(int count, QObject *parent)
+{
+    Q_ASSERT(count > 0);
+
+    QZmqWorkerPool *pool = new QZmqWorkerPool(parent);
+    pool->backend = QZmqSocket::create(ZMQ_ROUTER, pool);
+    if (pool->backend == NULL) {
+        delete pool;
+        return NULL;
+    }
+
+    // Report unknown and busy workers instead of dropping the requests silently.
+    // Workers reconnect with the same routing id when the pool is restarted.
+    int mandatory = 1;
+    int handover = 1;
+    QByteArray endpoint = "inproc://qzmq-worker-pool-" + QByteArray::number(reinterpret_cast<quintptr>(pool), 16);
+    if (!pool->backend->setOption(ZMQ_ROUTER_MANDATORY, &mandatory, sizeof(mandatory)) ||
+        !pool->backend->setOption(ZMQ_ROUTER_HANDOVER, &handover, sizeof(handover)) ||
+        !pool->backend->bind(endpoint.constData())) {
+        int error = QZmqError::getLastError();
+        delete pool;
+        errno = error;
+        return NULL;
+    }
+    pool->backend->setMultipartMode(true);
+    QObject::connect(pool->backend, &QZmqSocket::onMultipartMessage, pool, &QZmqWorkerPool::onBackendMessage);
+
+    for (int i = 0; i < count; i++) {
+        pool->workers.append(new QZmqWorker(i, endpoint));
+        QZmqWorkerStats stats;
+        stats.ready = false;
+        stats.outstanding = 0;
+        stats.dispatched = 0;
+        stats.completed = 0;
+        stats.throughput = 0;
+        pool->workerStats.append(stats);
+        CompletionWindow window = {};
+        pool->completions.append(window);
+    }
+    pool->clock.start();
+
+    return pool;
+}
+
+/**
+ * @brief   Start all worker threads.
+ *          QZmqWorkerPool::onWorkerReady() signal is emitted as the workers become ready.
+ */
+void QZmqWorkerPool::start()
+{
+    for (QZmqWorker *worker : this->workers) {
+        worker->start();
+    }
+}
+
+/**
+ * @brief   Stop all worker threads and wait until they exit.
+ *          Requests that are not handled yet are discarded.
+ *          The pool can be started again.
+ */
+void QZmqWorkerPool::stop()
+{
+    for (QZmqWorker *worker : this->workers) {
+        worker->quit();
+    }
+    for (int i = 0; i < this->workers.size(); i++) {
+        this->workers[i]->wait();
+        this->workerStats[i].ready = false;
+        this->workerStats[i].outstanding = 0;
+    }
+}
+
+/**
+ * @brief   Dispatch a request to the ready worker with the least outstanding requests.
+ *          On success, the message becomes empty. On failure, the frames of the request
+ *          that are not sent are left in the message, which normally is the whole request.
+ * 
+ * @param msg   The request.
+ * @return true     If the request is dispatched.
+ * @return false    If the operation is not successful. EAGAIN is reported if no worker is ready.
+ *                  Use QZmqError::getLastError() to get the error code.
+ */
+bool QZmqWorkerPool::dispatch(QZmqMultipartMessage &&msg)
+{
+    int index = selectWorker();
+    if (index < 0) {
+        errno = EAGAIN;
+        return false;
+    }
+
+    QByteArray id = QZmqWorker::routingId(index);
+    int size = msg.size();
+    msg.prepend(QZmqFrame(id.constData(), id.size()));
+    if (!this->backend->send(std::move(msg))) {
+        int error = QZmqError::getLastError();
+        if (msg.size() > size) {
+            msg.removeFirst(msg.size() - size);
+        }
+        errno = error;
+        return false;
+    }
+
+    QZmqWorkerStats &stats = this->workerStats[index];
+    stats.outstanding++;
+    stats.dispatched++;
+    return true;
+}
+
+/**
+ * @brief   Select the ready worker with the least outstanding requests.
+ *          Ties are broken in round robin order.
+ * 
+ * @return int  Index of the selected worker or -1 if no worker is ready.
+ */
+int QZmqWorkerPool::selectWorker()
+{
+    int count = this->workers.size();
+    int selected = -1;
+    for (int i = 0; i < count; i++) {
+        int index = (this->nextWorker + i) % count;
+        const QZmqWorkerStats &stats = this->workerStats[index];
+        if (!stats.ready) {
+            continue;
+        }
+        if (selected < 0 || stats.outstanding < this->workerStats[selected].outstanding) {
+            selected = index;
+            if (stats.outstanding == 0) {
+                break;
+            }
+        }
+    }
+
+    if (selected >= 0) {
+        this->nextWorker = (selected + 1) % count;
+    }
+    return selected;
+}
+
+/**
+ * @brief   Returns the number of worker threads.
+ * 
+ * @return int  Number of workers.
+ */
+int QZmqWorkerPool::workerCount()
+{
+    return this->workers.size();
+}
+
+/**
+ * @brief   Returns a worker of the pool.
+ * 
+ * @param index     Index of the worker.
+ * @return QZmqWorker*  A pointer to the worker.
+ */
+QZmqWorker* QZmqWorkerPool::worker(int index)
+{
+    return this->workers.at(index);
+}
+
+/**
+ * @brief   Pin a worker thread to a CPU. Must be called before the pool is started.
+ *          This is supported on Linux only and ignored elsewhere.
+ * 
+ * @param index     Index of the worker.
+ * @param cpu       Index of the CPU or -1 to let the scheduler decide.
+ */
+void QZmqWorkerPool::setCpuAffinity(int index, int cpu)
+{
+    this->workers.at(index)->cpu = cpu;
+}
+
+/**
+ * @brief   Returns the statistics of a worker.
+ *          The outstanding requests of a worker are its queue depth. The throughput is
+ *          the number of requests completed within the last second.
+ * 
+ * @param index     Index of the worker.
+ * @return QZmqWorkerStats  Statistics of the worker.
+ */
+QZmqWorkerStats QZmqWorkerPool::stats(int index)
+{
+    QZmqWorkerStats stats = this->workerStats.at(index);
+    CompletionWindow &window = this->completions[index];
+    advanceWindow(window);
+    quint64 completed = 0;
+    for (int i = 0; i < WINDOW_BUCKETS; i++) {
+        completed += window.counts[i];
+    }
+    stats.throughput = completed * 1000.0 / THROUGHPUT_WINDOW;
+    return stats;
+}
+
+/**
+ * @brief   Move a completion window to the current time.
+ *          Buckets that fall out of the window are cleared.
+ * 
+ * @param window    The completion window of a worker.
+ */
+void QZmqWorkerPool::advanceWindow(CompletionWindow &window)
+{
+    qint64 bucket = this->clock.elapsed() / (THROUGHPUT_WINDOW / WINDOW_BUCKETS);
+    qint64 elapsed = qMin<qint64>(bucket - window.bucket, WINDOW_BUCKETS);
+    for (qint64 i = 1; i <= elapsed; i++) {
+        window.counts[(window.bucket + i) % WINDOW_BUCKETS] = 0;
+    }
+    window.bucket = bucket;
+}
+
+/**
+ * @brief   This is the slot (function) for messages from the workers.
+ * 
+ * @param socket    The backend socket.
+ * @param msg       [routing id][type][payload...]
+ */
+void QZmqWorkerPool::onBackendMessage(QZmqSocket *socket, QZmqMultipartMessage *msg)
+{
+    int index = -1;
+    if (msg->size() >= 2 && msg->at(0).size() == 1 + sizeof(index) && msg->at(1).size() == 1) {
+        memcpy(&index, static_cast<const char*>(msg->at(0).data()) + 1, sizeof(index));
+    }
+    if (index < 0 || index >= this->workers.size()) {
+        delete msg;
+        return;
+    }
+
+    char type = *static_cast<const char*>(msg->at(1).data());
+    QZmqWorkerStats &stats = this->workerStats[index];
+    if (type == WORKER_READY) {
+        delete msg;
+        stats.ready = true;
+        emit onWorkerReady(this, index);
+        return;
+    }
+
+    if (stats.outstanding > 0) {
+        stats.outstanding--;
+    }
+    stats.completed++;
+    CompletionWindow &window = this->completions[index];
+    advanceWindow(window);
+    window.counts[window.bucket % WINDOW_BUCKETS]++;
+
+    msg->takeFirst();
+    msg->takeFirst();
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QZmqWorkerPool::onReply);
+    if (QObject::isSignalConnected(signal)) {
+        emit onReply(this, msg);
+    } else {
+        delete msg;
+    }
+}
+
+QZMQ_END_NAMESPACE
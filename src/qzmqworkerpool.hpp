@@ -0,0 +1,110 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __QZMQ_WORKER_POOL_H__
+#define __QZMQ_WORKER_POOL_H__
+
+#include "qzmqcommon.hpp"
+#include <QObject>
+#include <QThread>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+
+QZMQ_BEGIN_NAMESPACE
+
+class QZmqSocket;
+class QZmqMultipartMessage;
+
+// A thread of a QZmqWorkerPool with its own event loop and DEALER socket.
+// Requests are emitted through onRequest() in the worker thread.
+class QZMQ_API QZmqWorker : public QThread
+{
+    Q_OBJECT
+public:
+    virtual ~QZmqWorker();
+    int index();
+    bool reply(QZmqMultipartMessage &&msg);
+
+signals:
+    void onRequest(QZmqWorker *worker, QZmqMultipartMessage *msg);
+
+protected:
+    friend class QZmqWorkerPool;
+    QZmqWorker(int index, const QByteArray &endpoint, QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqWorker);
+    void run() override;
+    static QByteArray routingId(int index);
+
+    int workerIndex;
+    int cpu;
+    QByteArray endpoint;
+    QZmqSocket *socket;
+};
+
+struct QZmqWorkerStats
+{
+    bool ready;
+    int outstanding;
+    quint64 dispatched;
+    quint64 completed;
+    double throughput;      // Completed requests per second over the last second
+};
+
+class QZMQ_API QZmqWorkerPool : public QObject
+{
+    Q_OBJECT
+public:
+    static QZmqWorkerPool* create(int count, QObject *parent=nullptr);
+    virtual ~QZmqWorkerPool();
+    void start();
+    void stop();
+    bool dispatch(QZmqMultipartMessage &&msg);
+    int workerCount();
+    QZmqWorker* worker(int index);
+    void setCpuAffinity(int index, int cpu);
+    QZmqWorkerStats stats(int index);
+
+signals:
+    void onReply(QZmqWorkerPool *pool, QZmqMultipartMessage *msg);
+    void onWorkerReady(QZmqWorkerPool *pool, int index);
+
+protected slots:
+    void onBackendMessage(QZmqSocket *socket, QZmqMultipartMessage *msg);
+
+protected:
+    QZmqWorkerPool(QObject *parent=nullptr);
+    Q_DISABLE_COPY(QZmqWorkerPool);
+    int selectWorker();
+
+    // Completed requests of a worker in buckets of a sliding window.
+    static const int WINDOW_BUCKETS = 10;
+    struct CompletionWindow
+    {
+        quint32 counts[WINDOW_BUCKETS];
+        qint64 bucket;      // Current bucket since the creation of the pool
+    };
+    void advanceWindow(CompletionWindow &window);
+
+    QZmqSocket *backend;
+    QVector<QZmqWorker*> workers;
+    QVector<QZmqWorkerStats> workerStats;
+    QVector<CompletionWindow> completions;
+    QElapsedTimer clock;
+    int nextWorker;
+};
+
+QZMQ_END_NAMESPACE
+
+#endif // __QZMQ_WORKER_POOL_H__
@@ -0,0 +1,198 @@
+// Copyright 2019 Kasun Hewage
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Received frames are parsed by QZmqCompressor::decompress() before anything else looks
+// at them, so malformed headers from a peer must fail cleanly and without allocating.
+
+#include <qzmqcompressor.hpp>
+#include <qzmqerror.hpp>
+#include <zmq.h>
+#include <QByteArray>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                    \
+    do {                                                                    \
+        if (!(condition)) {                                                 \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+static void initMessage(zmq_msg_t *msg, const QByteArray &data)
+{
+    zmq_msg_init_size(msg, data.size());
+    memcpy(zmq_msg_data(msg), data.constData(), data.size());
+}
+
+static QByteArray content(zmq_msg_t *msg)
+{
+    return QByteArray(static_cast<const char*>(zmq_msg_data(msg)), static_cast<int>(zmq_msg_size(msg)));
+}
+
+// Header of a compressed frame: marker, algorithm and original size in little endian.
+static QByteArray header(char algorithm, quint32 originalSize)
+{
+    QByteArray data;
+    data.append(static_cast<char>(0xFF));
+    data.append(algorithm);
+    for (int i = 0; i < 4; i++) {
+        data.append(static_cast<char>((originalSize >> (8 * i)) & 0xFF));
+    }
+    return data;
+}
+
+// Decompress the given wire frame and return the error code, 0 on success.
+static int decompress(QZmqCompressor *compressor, const QByteArray &wire, QByteArray *result=NULL)
+{
+    zmq_msg_t msg;
+    zmq_msg_t out;
+    initMessage(&msg, wire);
+    int error = 0;
+    if (compressor->decompress(&msg, &out)) {
+        if (result != NULL) {
+            *result = content(&out);
+        }
+        zmq_msg_close(&out);
+    } else {
+        error = QZmqError::getLastError();
+    }
+    zmq_msg_close(&msg);
+    return error;
+}
+
+static void testPlainFrames(QZmqCompressor *compressor)
+{
+    QByteArray result;
+    CHECK(decompress(compressor, QByteArray(), &result) == 0 && result.isEmpty());
+    CHECK(decompress(compressor, QByteArray("plain"), &result) == 0 && result == "plain");
+}
+
+static void testTruncatedFrames(QZmqCompressor *compressor)
+{
+    // Marker byte only.
+    CHECK(decompress(compressor, QByteArray(1, static_cast<char>(0xFF))) == EPROTO);
+
+    // Compressed frames without the complete original size.
+    for (char algorithm : {static_cast<char>(QZmqCompressor::LZ4), static_cast<char>(QZmqCompressor::Zstd)}) {
+        int expected = QZmqCompressor::isSupported(static_cast<QZmqCompressor::Algorithm>(algorithm))
+                       ? EPROTO : EPROTONOSUPPORT;
+        QByteArray wire = header(algorithm, 16).left(4);
+        CHECK(decompress(compressor, wire) == expected);
+    }
+}
+
+static void testEscapedFrames(QZmqCompressor *compressor)
+{
+    QByteArray result;
+    QByteArray wire;
+    wire.append(static_cast<char>(0xFF));
+    wire.append(static_cast<char>(QZmqCompressor::None));
+    CHECK(decompress(compressor, wire, &result) == 0 && result.isEmpty());
+
+    wire.append(static_cast<char>(0xFF));
+    wire.append("raw");
+    CHECK(decompress(compressor, wire, &result) == 0 && result == QByteArray("\xFF" "raw"));
+
+    // A frame that starts with the marker byte is escaped on the way out and restored.
+    QByteArray original("\xFF" "starts with the marker");
+    zmq_msg_t msg;
+    zmq_msg_t out;
+    initMessage(&msg, original);
+    CHECK(compressor->compress(&msg, &out));
+    QByteArray escaped = content(&out);
+    zmq_msg_close(&out);
+    zmq_msg_close(&msg);
+    CHECK(escaped.size() == original.size() + 2);
+    CHECK(decompress(compressor, escaped, &result) == 0 && result == original);
+}
+
+static void testBogusHeaders(QZmqCompressor *compressor)
+{
+    // Unknown algorithms are rejected before the original size they claim is looked at.
+    for (char algorithm : {static_cast<char>(3), static_cast<char>(0x7F), static_cast<char>(0xFF)}) {
+        CHECK(decompress(compressor, header(algorithm, 64) + QByteArray(8, 'x')) == EPROTO);
+        CHECK(decompress(compressor, header(algorithm, 0xFFFFFFFF) + QByteArray(8, 'x')) == EPROTO);
+    }
+
+    for (char algorithm : {static_cast<char>(QZmqCompressor::LZ4), static_cast<char>(QZmqCompressor::Zstd)}) {
+        if (!QZmqCompressor::isSupported(static_cast<QZmqCompressor::Algorithm>(algorithm))) {
+            CHECK(decompress(compressor, header(algorithm, 1024) + QByteArray(8, 'x')) == EPROTONOSUPPORT);
+            CHECK(decompress(compressor, header(algorithm, 0xFFFFFFFF) + QByteArray(8, 'x')) == EPROTONOSUPPORT);
+            continue;
+        }
+        // Original sizes beyond the limit or beyond what the compressed size can restore.
+        CHECK(decompress(compressor, header(algorithm, 0xFFFFFFFF) + QByteArray(8, 'x')) == EMSGSIZE);
+        CHECK(decompress(compressor, header(algorithm, 32 * 1024 * 1024) + QByteArray(8, 'x')) == EPROTO);
+        // Garbage that claims a plausible size.
+        CHECK(decompress(compressor, header(algorithm, 64) + QByteArray(8, 'x')) == EPROTO);
+    }
+}
+
+static void testRoundTrip(QZmqCompressor::Algorithm algorithm)
+{
+    if (!QZmqCompressor::isSupported(algorithm)) {
+        return;
+    }
+    QZmqCompressor *compressor = QZmqCompressor::create(algorithm);
+    CHECK(compressor != NULL);
+    if (compressor == NULL) {
+        return;
+    }
+
+    QByteArray original;
+    for (int i = 0; i < 1000; i++) {
+        original.append("compressible content ");
+    }
+    zmq_msg_t msg;
+    zmq_msg_t out;
+    initMessage(&msg, original);
+    CHECK(compressor->compress(&msg, &out));
+    CHECK(QZmqCompressor::isCompressed(&out));
+    QByteArray wire = content(&out);
+    zmq_msg_close(&out);
+    zmq_msg_close(&msg);
+
+    QByteArray result;
+    CHECK(decompress(compressor, wire, &result) == 0 && result == original);
+    // A truncated frame must not decompress.
+    CHECK(decompress(compressor, wire.left(wire.size() - 1)) != 0);
+    delete compressor;
+}
+
+int main(int argc, char **argv)
+{
+    Q_UNUSED(argc);
+    Q_UNUSED(argv);
+
+    QZmqCompressor *compressor = QZmqCompressor::create(QZmqCompressor::None);
+    testPlainFrames(compressor);
+    testTruncatedFrames(compressor);
+    testEscapedFrames(compressor);
+    testBogusHeaders(compressor);
+    delete compressor;
+
+    testRoundTrip(QZmqCompressor::LZ4);
+    testRoundTrip(QZmqCompressor::Zstd);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}